@@ -0,0 +1,219 @@
+// Headless microbenchmarks for the parsing and drawing hot paths. Prints one
+// JSON document to stdout with the time and heap allocations per operation.
+// Run through `make bench`, which uses SDL's dummy video driver.
+#include <SDL.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include "fixtures.h"
+#include "game_list_parser.h"
+#include "renderer.h"
+#include "ui_manager.h"
+#include "utils.h"
+
+// Every C++ allocation goes through these, and libxml2 is pointed at the
+// counting wrappers below, so allocs/op covers both.
+static std::atomic<long long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+static void* xmlCountingMalloc(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size);
+}
+
+static void* xmlCountingRealloc(void* p, size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return realloc(p, size);
+}
+
+static char* xmlCountingStrdup(const char* text) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return strdup(text);
+}
+
+struct BenchResult {
+    std::string name;
+    long long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+static const double MIN_SECONDS = 0.5;
+
+// Runs op in growing batches until a batch takes MIN_SECONDS, after one
+// untimed call to warm caches and lazily built state.
+static BenchResult measure(const std::string& name, const std::function<void()>& op) {
+    op();
+    long long batch = 1;
+    for (;;) {
+        long long allocsBefore = allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < batch; i++) {
+            op();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long allocs = allocations.load() - allocsBefore;
+        if (seconds >= MIN_SECONDS || batch >= (1LL << 30)) {
+            return {name, batch, seconds * 1e9 / batch, (double)allocs / batch};
+        }
+        batch = seconds > 0 ? std::max(batch * 2, (long long)(batch * MIN_SECONDS * 1.2 / seconds)) : batch * 100;
+    }
+}
+
+static ResponseBuffer bodyOf(const std::string& text) {
+    ResponseBuffer body;
+    body.reserve(text.size());
+    body.append(text.data(), text.size());
+    return body;
+}
+
+int main(int argc, char* argv[]) {
+    xmlMemSetup(free, xmlCountingMalloc, xmlCountingRealloc, xmlCountingStrdup);
+    xmlInitParser();
+
+    // The code under test logs to std::cout; keep stdout for the JSON.
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    std::vector<BenchResult> results;
+    std::vector<std::string> skipped;
+
+    ResponseBuffer consoles = bodyOf(consoleListFixture(60));
+    results.push_back(measure("parseHTML/60_consoles", [&] { parseHTML(consoles); }));
+
+    const struct {
+        const char* name;
+        int rows;
+    } pages[] = {{"small", 25}, {"medium", 400}, {"huge", 4000}};
+    for (const auto& page : pages) {
+        std::string html = letterPageFixture(page.rows);
+        ResponseBuffer body = bodyOf(html);
+        results.push_back(measure(std::string("parseGamesHTML/") + page.name, [&] { parseGamesHTML(body); }));
+        results.push_back(measure(std::string("GameListParser/") + page.name, [&] {
+            GameListParser parser([](const Game&) {});
+            for (size_t pos = 0; pos < html.size(); pos += 16384) {
+                parser.feed(html.data() + pos, std::min<size_t>(16384, html.size() - pos));
+            }
+            parser.finish();
+        }));
+    }
+
+    // Receiving a page in 16 KB chunks, as curl hands it over, with and
+    // without a Content-Length to size the buffer from.
+    std::string huge = letterPageFixture(4000);
+    for (bool sized : {true, false}) {
+        results.push_back(measure(std::string("ResponseBuffer::append/huge_") + (sized ? "sized" : "chunked"), [&] {
+            ResponseBuffer body;
+            if (sized) {
+                body.reserve(huge.size());
+            }
+            for (size_t pos = 0; pos < huge.size(); pos += 16384) {
+                body.append(huge.data() + pos, std::min<size_t>(16384, huge.size() - pos));
+            }
+        }));
+    }
+
+    ResponseBuffer detail = bodyOf(detailPageFixture());
+    results.push_back(measure("parseMediaId/detail_page", [&] { parseMediaId(detail); }));
+
+    // Drawing goes through the software renderer so it works without a GPU;
+    // every op is a whole frame including the present.
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    Renderer renderer;
+    if (renderer.initialize()) {
+        UIManager uiManager(renderer);
+        GameList games = gamesFixture(400);
+        SDL_Color color = {255, 255, 255, 255};
+        SDL_Rect panel = {10, 10, 620, 460};
+
+        results.push_back(measure("Renderer::present/empty_frame", [&] {
+            renderer.clear();
+            renderer.present();
+        }));
+        results.push_back(measure("Renderer::drawText/40_lines", [&] {
+            renderer.clear();
+            for (int i = 0; i < 40; i++) {
+                renderer.drawText(std::string(games.title(i)), 50, 50 + (i % 20) * 30, color);
+            }
+            renderer.present();
+        }));
+        results.push_back(measure("Renderer::drawRoundedRect/panel", [&] {
+            renderer.clear();
+            renderer.drawRoundedRect(panel, 20, 5);
+            renderer.present();
+        }));
+        int tick = 0;
+        results.push_back(measure("UIManager::drawGameList/40_rows", [&] {
+            renderer.clear();
+            uiManager.drawGameList(games, 5, tick++);
+            renderer.present();
+        }));
+    } else {
+        skipped.push_back("renderer: initialization failed (needs res/ and SDL's dummy video driver)");
+    }
+
+    std::cout.rdbuf(coutBuffer);
+    FILE* out = stdout;
+    if (argc > 1 && !(out = fopen(argv[1], "w"))) {
+        fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.1f, \"allocs_per_op\": %.1f}%s\n",
+                r.name.c_str(), r.iterations, r.nsPerOp, r.allocsPerOp, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"skipped\": [");
+    for (size_t i = 0; i < skipped.size(); i++) {
+        fprintf(out, "%s\"%s\"", i ? ", " : "", skipped[i].c_str());
+    }
+    fprintf(out, "]\n}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
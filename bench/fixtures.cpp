@@ -0,0 +1,63 @@
+#include "fixtures.h"
+
+static const char* const WORDS[] = {"Super", "Mega", "Legend", "Final", "Fantasy", "Street", "Fighter", "Dragon", "Quest",
+                                    "Metal", "Racing", "World", "Star", "Tactics", "Adventure", "Kart", "Party", "Soccer"};
+static const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+static std::string titleFor(unsigned int& seed, int index) {
+    std::string title;
+    for (int i = 0; i < 3 + index % 3; i++) {
+        seed = seed * 1103515245 + 12345;
+        title += (i ? " " : "") + std::string(WORDS[(seed >> 16) % WORD_COUNT]);
+    }
+    return title + " " + std::to_string(index);
+}
+
+std::string consoleListFixture(int consoleCount) {
+    std::string html = "<html><head><title>The Vault</title></head><body><div id=\"main\">"
+                       "<div style=\"display:flex; justify-content:center; align-items:flex-start; flex-wrap:wrap; gap:15px; margin:auto\">";
+    for (int i = 0; i < consoleCount; i++) {
+        html += "<div class=\"console\"><a href=\"/vault/SYS" + std::to_string(i) + "\">System " + std::to_string(i) + "</a></div>";
+    }
+    return html + "</div></div></body></html>";
+}
+
+std::string letterPageFixture(int rowCount) {
+    unsigned int seed = 42;
+    std::string html = "<html><head><title>Vault</title></head><body><table class=\"rounded centered cellpadding1 hovertable striped\">"
+                       "<caption>Games</caption><tr><th>Title</th><th>Region</th><th>Version</th><th>Languages</th><th>Rating</th></tr>";
+    for (int i = 0; i < rowCount; i++) {
+        std::string id = std::to_string(10000 + i);
+        html += "<tr><td style=\"width:auto\"><a href=\"/vault/" + id + "\">" + titleFor(seed, i) + "</a></td>"
+                "<td><img class=\"flag\" src=\"/images/flags/us.png\" title=\"USA\"></td>"
+                "<td>1." + std::to_string(i % 3) + "</td><td>En,Fr,De</td>"
+                "<td><a href=\"/vault/?p=rating&amp;id=" + id + "\">" + std::to_string(i % 10) + ".5</a></td></tr>";
+    }
+    return html + "</table></body></html>";
+}
+
+std::string detailPageFixture() {
+    std::string html = "<html><head><title>Game</title></head><body><table id=\"data-good\">";
+    html += "<tr><td>CRC</td><td id=\"data-crc\">1A2B3C4D</td></tr><tr><td>MD5</td><td id=\"data-md5\">00112233445566778899aabbccddeeff</td></tr>"
+            "<tr><td>SHA1</td><td id=\"data-sha1\">00112233445566778899aabbccddeeff00112233</td></tr></table>";
+    // Detail pages carry a long description and screenshot list before the form.
+    for (int i = 0; i < 200; i++) {
+        html += "<p class=\"description\">Paragraph " + std::to_string(i) + " of the game description text.</p>";
+    }
+    html += "<form id=\"dl_form\" action=\"https://download2.vimm.net/\" method=\"POST\">"
+            "<input type=\"hidden\" name=\"mediaId\" value=\"54321\"><input type=\"hidden\" name=\"alt\" value=\"0\">"
+            "<button type=\"submit\">Download</button></form></body></html>";
+    return html;
+}
+
+GameList gamesFixture(int count) {
+    unsigned int seed = 7;
+    GameList games;
+    for (int i = 0; i < count; i++) {
+        Game game;
+        game.title = titleFor(seed, i);
+        game.url = "/vault/" + std::to_string(10000 + i);
+        games.add(game);
+    }
+    return games;
+}
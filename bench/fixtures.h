@@ -0,0 +1,15 @@
+#ifndef BENCH_FIXTURES_H
+#define BENCH_FIXTURES_H
+
+#include <string>
+#include <vector>
+#include "game_list.h"
+
+// Pages shaped like the vimm.net markup the parsers target, generated with a
+// fixed seed so every run parses the same bytes.
+std::string consoleListFixture(int consoleCount);
+std::string letterPageFixture(int rowCount);
+std::string detailPageFixture();
+GameList gamesFixture(int count);
+
+#endif // BENCH_FIXTURES_H
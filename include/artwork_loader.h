@@ -0,0 +1,72 @@
+#ifndef ARTWORK_LOADER_H
+#define ARTWORK_LOADER_H
+
+#include <SDL.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "config.h"
+#include "http_cache.h"
+
+// Fetches, decodes and downscales artwork on worker threads. Images come
+// from the on-card art cache or over HTTP, are decoded and shrunk to fit
+// the requested box, and are handed back as surfaces through drain(); the
+// render thread only uploads them. request() replaces whatever was asked
+// for before: queued images that are no longer wanted are dropped and
+// their transfers abandoned.
+class ArtworkLoader {
+public:
+    typedef std::function<void()> WakeCallback;
+
+    struct Ready {
+        std::string url;
+        int w;
+        int h;
+        SDL_Surface* surface; // owned by the caller after drain()
+    };
+
+    explicit ArtworkLoader(WakeCallback wake, int workerCount = ARTWORK_WORKERS);
+    ~ArtworkLoader();
+
+    // The current selection goes on the interactive lane; the prefetches,
+    // in priority order, go on the bulk lane behind it.
+    void request(const std::string& selected, const std::vector<std::string>& prefetch, int w, int h);
+    void cancel();
+    bool drain(std::vector<Ready>& ready);
+    bool failed(const std::string& url);
+
+    static std::string boxArtUrl(std::string_view gameUrl);
+
+private:
+    struct Job {
+        std::string url;
+        int w;
+        int h;
+        TransferLane lane;
+    };
+
+    void worker();
+    void process(const Job& job);
+    bool wanted(const std::string& url);
+    static SDL_Surface* decode(const ResponseBuffer& data, int w, int h);
+
+    WakeCallback wake;
+    HttpCache cache;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+    std::deque<Job> queue;
+    std::unordered_set<std::string> wantedUrls;
+    std::unordered_set<std::string> inFlight;
+    std::unordered_set<std::string> failedUrls;
+    std::vector<Ready> ready;
+    std::vector<std::thread> workers;
+};
+
+#endif // ARTWORK_LOADER_H
@@ -0,0 +1,18 @@
+#ifndef BATCH_DOWNLOAD_H
+#define BATCH_DOWNLOAD_H
+
+#include <string>
+
+// Headless mode behind `octolair --batch <list>`: no SDL is initialized.
+// Each non-empty line of the list names one game as
+//
+//     <console> | <title or vault id>
+//
+// where the console is its name or vault code ("Nintendo 64" or "N64"); a
+// line starting with '#' is a comment. Everything that resolves is run
+// through the normal DownloadManager queue; progress goes to stdout and a
+// summary is printed at the end. Returns the process exit status: 0 only
+// if every line was downloaded.
+int runBatchDownload(const std::string& listPath);
+
+#endif // BATCH_DOWNLOAD_H
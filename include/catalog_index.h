@@ -0,0 +1,88 @@
+#ifndef CATALOG_INDEX_H
+#define CATALOG_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "types.h"
+#include "game_list.h"
+
+// Read-only view of one console's whole catalog, memory-mapped from a file
+// written by CatalogIndex::write(). The file is a header with per-letter
+// record ranges, an array of fixed-width records holding string offsets,
+// and a pool of NUL-terminated strings, so opening it parses nothing and a
+// letter is just a range of records. Only the header and the letter table
+// are checked on open; string offsets are checked as they are read.
+class CatalogIndex {
+public:
+    static const int LETTER_COUNT = 27; // "#", then A-Z
+
+    // A range of records read straight from the mapping, valid while the
+    // index stays open.
+    class Slice {
+    public:
+        Slice();
+
+        size_t size() const;
+        bool empty() const;
+        std::string_view title(size_t index) const;
+        std::string_view url(size_t index) const;
+        Game game(size_t index) const;
+
+    private:
+        friend class CatalogIndex;
+        Slice(const CatalogIndex* index, size_t begin, size_t end);
+
+        const CatalogIndex* index;
+        size_t begin;
+        size_t end;
+    };
+
+    CatalogIndex();
+    ~CatalogIndex();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    size_t size() const;
+    size_t letterBegin(int letter) const;
+    size_t letterEnd(int letter) const;
+    const char* title(size_t index) const;
+    const char* url(size_t index) const;
+    Game game(size_t index) const;
+    Slice letter(int letter) const;
+
+    static bool write(const std::string& path, const std::vector<GameList>& letters);
+    static std::string pathFor(const Console& console);
+    static std::string letterName(int letter);
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordCount;
+        uint32_t poolSize;
+        uint32_t letterOffsets[LETTER_COUNT + 1];
+    };
+
+    struct Record {
+        uint32_t title;
+        uint32_t region;
+        uint32_t version;
+        uint32_t languages;
+        uint32_t rating;
+        uint32_t url;
+    };
+
+    const char* string(uint32_t offset) const;
+
+    void* mapping;
+    size_t mappingSize;
+    const Header* header;
+    const Record* records;
+    const char* pool;
+};
+
+#endif // CATALOG_INDEX_H
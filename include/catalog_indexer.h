@@ -0,0 +1,33 @@
+#ifndef CATALOG_INDEXER_H
+#define CATALOG_INDEXER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+// Background crawl that keeps a CatalogIndex file per console up to date.
+// Consoles are visited one at a time, fetching each of the 27 letter pages
+// in turn, and an index younger than CATALOG_INDEX_MAX_AGE is left alone.
+class CatalogIndexer {
+public:
+    typedef std::function<void(const Console&)> IndexedCallback;
+
+    CatalogIndexer(const std::vector<Console>& consoles, IndexedCallback onIndexed);
+    ~CatalogIndexer();
+
+    static bool fresh(const std::string& path);
+
+private:
+    void run();
+    bool crawl(const Console& console);
+
+    std::vector<Console> consoles;
+    IndexedCallback onIndexed;
+    std::atomic<bool> stopping;
+    std::thread worker;
+};
+
+#endif // CATALOG_INDEXER_H
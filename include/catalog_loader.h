@@ -0,0 +1,55 @@
+#ifndef CATALOG_LOADER_H
+#define CATALOG_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "game_list.h"
+
+// Loads letter pages on a worker thread so the render loop never waits on
+// the network. Rows are handed over through drain() as they are parsed, and
+// the wake callback fires whenever there is something new to pick up.
+// Starting a new load or calling cancel() abandons the current page. Once a
+// page is done, the worker warms the cache with the neighbouring letters.
+class CatalogLoader {
+public:
+    typedef std::function<void()> WakeCallback;
+
+    explicit CatalogLoader(WakeCallback wake);
+    ~CatalogLoader();
+
+    void load(const std::string& url, const std::vector<std::string>& prefetchUrls);
+    void cancel();
+    bool drain(GameList& games);
+    bool loading();
+
+private:
+    struct Request {
+        std::string url;
+        std::vector<std::string> prefetchUrls;
+    };
+
+    void run();
+    void fetchPage(const Request& request, unsigned int generation);
+    void prefetch(const std::string& url, unsigned int generation);
+    void publish(const Game* game, unsigned int generation, bool done);
+
+    WakeCallback wake;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<unsigned int> generation;
+    bool stopping;
+    bool hasRequest;
+    bool busy;
+    Request request;
+    std::deque<std::string> prefetchQueue;
+    GameList rows;
+    std::thread worker;
+};
+
+#endif // CATALOG_LOADER_H
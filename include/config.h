@@ -4,7 +4,66 @@
 #define SCREEN_WIDTH 1280
 #define SCREEN_HEIGHT 720
 
+// Upper bound on decoded image textures kept by Renderer::textures()
+#define TEXTURE_CACHE_BUDGET (16 * 1024 * 1024)
 
+// Games downloaded at the same time by DownloadManager
+#define DOWNLOAD_WORKERS 2
 
+// Parallel ranged connections used per ROM download (see setDownloadSegments)
+#define DOWNLOAD_SEGMENTS 4
+#define MIN_SEGMENT_SIZE (1024 * 1024)
+#define SEGMENT_RETRIES 3
+// Bytes downloaded between .part sidecar commits, and full attempts per ROM
+#define PART_COMMIT_INTERVAL (4 * 1024 * 1024)
+#define DOWNLOAD_RETRIES 3
+// Whether downloads that are unpacked on arrival also keep the archive
+#define KEEP_ARCHIVES 0
+// Downloads reach the card through write-behind buffers of this size; at
+// most this many are in flight before the network threads wait for it
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+#define OUTPUT_BUFFER_COUNT 8
 
-#endif 
\ No newline at end of file
+// Bandwidth limits in bytes per second, 0 for none. Interactive covers page
+// and artwork loads, bulk covers ROM downloads; the global cap covers both
+// and can be changed from the shoulder buttons. While a page loads without
+// a cap, downloads drop to this percentage of their previous rate.
+#define TRANSFER_INTERACTIVE_LIMIT 0
+#define TRANSFER_BULK_LIMIT 0
+#define TRANSFER_GLOBAL_LIMIT 0
+#define TRANSFER_BURST_MS 250
+#define INTERACTIVE_BULK_SHARE 25
+// Finished requests kept for the stats overlay; all are logged to disk
+#define TRANSFER_STATS_HISTORY 64
+// Page bodies grow in segments of this size when the server sends no
+// Content-Length; freed buffers are kept for reuse up to the pool size
+#define RESPONSE_SEGMENT_SIZE (64 * 1024)
+#define RESPONSE_POOL_BYTES (4 * 1024 * 1024)
+
+// Box art: decode threads, and how many games after the selection get
+// their art fetched ahead of time
+#define ARTWORK_WORKERS 2
+#define ARTWORK_PREFETCH 3
+
+// On-card cache for catalog pages, relative to the app folder like res/
+#define CACHE_DIR "cache"
+
+// Per-console catalog index files: how long one stays valid before it is
+// crawled again, and the pause between letter pages while crawling
+#define CATALOG_INDEX_MAX_AGE (7 * 24 * 60 * 60)
+#define CATALOG_CRAWL_DELAY_MS 250
+
+// Most titles a search shows; the rest are only counted
+#define SEARCH_RESULT_LIMIT 200
+
+// Idle pacing of the main loop: marquee step, how often background state
+// (downloads, streamed rows) is polled, and how often frame stats are logged
+#define MARQUEE_INTERVAL_MS 133
+#define STATUS_POLL_MS 100
+#define FRAME_STATS_INTERVAL_MS 10000
+
+// How often --batch mode prints per-download progress and throughput
+#define BATCH_PROGRESS_INTERVAL_MS 5000
+
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 as used by zip and the vault's published checksums. Start from 0
+// and feed the data in order; the value after the last call is the CRC.
+// Uses the ARMv8 CRC32 instructions when the CPU reports them and a
+// slice-by-8 table otherwise.
+uint32_t crc32Update(uint32_t crc, const void* data, size_t size);
+// CRC of two pieces back to back, from the CRC of each and the length of
+// the second, so parts hashed separately never have to be read again.
+uint32_t crc32Combine(uint32_t first, uint32_t second, long long secondLength);
+const char* crc32Implementation();
+
+#endif // CRC32_H
@@ -0,0 +1,101 @@
+#ifndef CURL_API_H
+#define CURL_API_H
+
+#include <string>
+
+// libcurl is loaded at runtime from the device's /usr/lib, so only the symbols
+// and option ids OctoLair actually uses are declared here.
+typedef void CURL;
+typedef void CURLSH;
+struct curl_slist;
+typedef long long curl_off_t;
+
+typedef CURL* (*curl_easy_init_t)();
+typedef void (*curl_easy_cleanup_t)(CURL*);
+typedef int (*curl_easy_setopt_t)(CURL*, int, ...);
+typedef int (*curl_easy_perform_t)(CURL*);
+typedef int (*curl_easy_getinfo_t)(CURL*, int, ...);
+typedef const char* (*curl_easy_strerror_t)(int);
+typedef struct curl_slist* (*curl_slist_append_t)(struct curl_slist*, const char*);
+typedef void (*curl_slist_free_all_t)(struct curl_slist*);
+typedef int (*curl_global_init_t)(long);
+typedef void (*curl_easy_reset_t)(CURL*);
+typedef CURLSH* (*curl_share_init_t)();
+typedef int (*curl_share_setopt_t)(CURLSH*, int, ...);
+typedef int (*curl_share_cleanup_t)(CURLSH*);
+typedef void (*curl_lock_function_t)(CURL*, int, int, void*);
+typedef void (*curl_unlock_function_t)(CURL*, int, void*);
+
+enum {
+    CURLOPT_WRITEDATA = 10001,
+    CURLOPT_URL = 10002,
+    CURLOPT_RANGE = 10007,
+    CURLOPT_HTTPHEADER = 10023,
+    CURLOPT_HEADERDATA = 10029,
+    CURLOPT_XFERINFODATA = 10057,
+    CURLOPT_SHARE = 10100,
+    CURLOPT_WRITEFUNCTION = 20011,
+    CURLOPT_HEADERFUNCTION = 20079,
+    CURLOPT_XFERINFOFUNCTION = 20219,
+    CURLOPT_NOPROGRESS = 43,
+    CURLOPT_FOLLOWLOCATION = 52,
+    CURLOPT_SSL_VERIFYPEER = 64,
+    CURLOPT_SSL_VERIFYHOST = 81,
+    CURLOPT_NOSIGNAL = 99,
+    CURLOPT_TCP_KEEPALIVE = 213
+};
+
+enum {
+    CURLSHOPT_SHARE = 1,
+    CURLSHOPT_LOCKFUNC = 3,
+    CURLSHOPT_UNLOCKFUNC = 4,
+    CURLSHOPT_USERDATA = 5
+};
+
+enum {
+    CURL_LOCK_DATA_SHARE = 1,
+    CURL_LOCK_DATA_DNS = 3,
+    CURL_LOCK_DATA_SSL_SESSION = 4,
+    CURL_LOCK_DATA_CONNECT = 5,
+    CURL_LOCK_DATA_LAST = 7
+};
+
+#define CURL_GLOBAL_ALL 3
+
+enum {
+    CURLINFO_RESPONSE_CODE = 0x200002,
+    CURLINFO_TOTAL_TIME = 0x300003,
+    CURLINFO_NAMELOOKUP_TIME = 0x300004,
+    CURLINFO_CONNECT_TIME = 0x300005,
+    CURLINFO_SIZE_DOWNLOAD = 0x300008,
+    CURLINFO_SPEED_DOWNLOAD = 0x300009,
+    CURLINFO_STARTTRANSFER_TIME = 0x300011,
+    CURLINFO_APPCONNECT_TIME = 0x300021
+};
+
+enum {
+    CURLE_OK = 0,
+    CURLE_WRITE_ERROR = 23
+};
+
+struct CurlApi {
+    void* handle = nullptr;
+    curl_easy_init_t easy_init = nullptr;
+    curl_easy_cleanup_t easy_cleanup = nullptr;
+    curl_easy_setopt_t easy_setopt = nullptr;
+    curl_easy_perform_t easy_perform = nullptr;
+    curl_easy_getinfo_t easy_getinfo = nullptr;
+    curl_easy_strerror_t easy_strerror = nullptr;
+    curl_slist_append_t slist_append = nullptr;
+    curl_slist_free_all_t slist_free_all = nullptr;
+    curl_global_init_t global_init = nullptr;
+    curl_easy_reset_t easy_reset = nullptr;
+    curl_share_init_t share_init = nullptr;
+    curl_share_setopt_t share_setopt = nullptr;
+    curl_share_cleanup_t share_cleanup = nullptr;
+
+    bool load();
+    void unload();
+};
+
+#endif // CURL_API_H
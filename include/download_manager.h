@@ -2,37 +2,75 @@
 #define DOWNLOAD_MANAGER_H
 
 #include <atomic>
-#include <queue>
+#include <chrono>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <string>
 #include <vector>
 #include <thread>
+#include "config.h"
 
+class ExtractionQueue;
+
+enum class DownloadState {
+    Queued,
+    Resolving,
+    Downloading,
+    Extracting,
+    Done,
+    Failed
+};
+
+const char* downloadStateName(DownloadState state);
+
+struct DownloadItem {
+    int id = 0;
+    std::string console;
+    std::string url;
+    std::string title;
+    DownloadState state = DownloadState::Queued;
+    long long bytesDone = 0;
+    long long bytesTotal = 0;
+    double bytesPerSecond = 0.0;
+};
+
+// Runs queued game downloads on a fixed pool of workers, so small ROMs do
+// not wait behind a large disc image. Every entry keeps its own state
+// record; snapshot() copies all of them under one lock for the UI. With an
+// extraction queue, finished archives are unpacked there instead of on the
+// download worker.
 class DownloadManager {
 public:
-    DownloadManager();
+    explicit DownloadManager(ExtractionQueue* extractionQueue = nullptr, int workerCount = DOWNLOAD_WORKERS);
     ~DownloadManager();
 
-    void queueDownload(const std::string& console, const std::string& url, const std::string& gameTitle);
-    void start();
-
-    std::atomic<int> downloadProgress;
-    std::atomic<bool> isDownloading;
-
-    std::string getFirstQueuedGameTitle();
-    std::vector<std::string> getQueuedGameTitles();
+    int queueDownload(const std::string& console, const std::string& url, const std::string& gameTitle);
+    std::vector<DownloadItem> snapshot();
+    bool busy();
+    unsigned int version() const;
 
 private:
-    void downloadGameThread(const std::string& console, const std::string& url, const std::string& gameTitle);
-    void processDownloadQueue();
+    struct Record {
+        DownloadItem item;
+        std::chrono::steady_clock::time_point sampleTime;
+        long long sampleBytes = 0;
+    };
+
+    void worker();
+    void process(int id);
+    void setState(int id, DownloadState state);
+    bool updateProgress(int id, long long done, long long total);
 
-    std::queue<std::pair<std::string, std::string>> downloadQueue;
-    std::vector<std::string> queuedGameTitles;
+    ExtractionQueue* extractionQueue;
+    std::vector<Record> records;
+    std::deque<int> pending;
+    int active;
     std::mutex queueMutex;
     std::condition_variable queueCV;
-    std::thread queueThread;
+    std::vector<std::thread> workers;
     bool stopThread;
+    std::atomic<unsigned int> changes;
 };
 
-#endif // DOWNLOAD_MANAGER_H
\ No newline at end of file
+#endif // DOWNLOAD_MANAGER_H
@@ -0,0 +1,73 @@
+#ifndef EXTRACTION_QUEUE_H
+#define EXTRACTION_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+enum class ExtractState {
+    Queued,
+    Running,
+    Done,
+    Failed
+};
+
+struct ExtractJob {
+    int id = 0;
+    std::string archive;
+    std::string outputDir;
+    ExtractState state = ExtractState::Queued;
+    int percent = 0;
+    bool removeArchive = false;
+};
+
+// Unpacks archives already on the card with 7zz, one job per archive on a
+// pool sized to the core count. A manifest of (path, size, mtime) records
+// what has been extracted, so scanning a folder again only queues archives
+// that are new or have changed since. Downloads hand their archives over
+// here too, optionally to be deleted once they are unpacked.
+class ExtractionQueue {
+public:
+    explicit ExtractionQueue(const std::string& manifestPath, int workerCount = 0);
+    ~ExtractionQueue();
+
+    int scan(const std::string& romPath);
+    bool enqueue(const std::string& archive, const std::string& outputDir, bool removeArchive = false);
+    std::vector<ExtractJob> snapshot();
+    bool busy();
+    unsigned int version() const;
+
+private:
+    struct Stamp {
+        long long size;
+        long long mtime;
+    };
+
+    void loadManifest();
+    void saveManifest();
+    bool stampOf(const std::string& archive, Stamp& stamp);
+    bool extracted(const std::string& archive, Stamp& stamp);
+    void worker();
+    bool run(int id);
+    void setPercent(int id, int percent);
+
+    std::string manifestPath;
+    std::unordered_map<std::string, Stamp> manifest;
+    std::vector<ExtractJob> jobs;
+    std::deque<int> pending;
+    std::unordered_map<int, pid_t> children;
+    int active;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+    bool stopping;
+    std::atomic<unsigned int> changes;
+};
+
+#endif // EXTRACTION_QUEUE_H
@@ -0,0 +1,45 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SDL.h>
+
+// Drives the main loop on invalidation instead of spinning. Anything that
+// changes what is on screen calls invalidate(); anything that needs a look
+// at a known time (marquee step, key repeat, polling a worker) calls
+// wakeAt(). waitEvent() sleeps until an event arrives or the earliest wake
+// time passes, and render() tells the loop whether a redraw is due.
+class FramePacer {
+public:
+    FramePacer();
+
+    void invalidate();
+    void wakeAt(Uint32 ticks);
+    bool waitEvent(SDL_Event& event);
+
+    bool render();
+    void drawn();
+    void presented();
+    void report(bool force = false);
+    // Milliseconds from render() to drawn(), smoothed over recent frames;
+    // the wait for vsync in present() is left out.
+    double frameTime() const;
+
+private:
+    static double threadCpuSeconds();
+
+    bool dirty;
+    bool hasDeadline;
+    Uint32 deadline;
+
+    Uint64 frameStart;
+    double frameMs;
+
+    Uint32 windowStart;
+    double cpuStart;
+    unsigned long frames;
+    unsigned long wakeups;
+    unsigned long totalFrames;
+    unsigned long totalWakeups;
+};
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,62 @@
+#ifndef GAME_LIST_H
+#define GAME_LIST_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "types.h"
+
+// The rows of a letter page or a whole catalog, stored column by column.
+// Titles and URLs are appended to one character pool owned by the list.
+// Region, version, languages and rating repeat on thousands of rows, so
+// they are interned once and each row keeps a 16-bit id. The intern table
+// is an open-addressed array of ids that compares against the pool, so a
+// value seen before costs no allocation. The string_views returned point
+// into the pool and stay valid until the list is changed.
+class GameList {
+public:
+    size_t size() const;
+    bool empty() const;
+    void clear();
+    void reserve(size_t games, size_t textBytes);
+
+    void add(std::string_view title, std::string_view region, std::string_view version, std::string_view languages,
+             std::string_view rating, std::string_view url);
+    void add(const Game& game);
+    void append(const GameList& other);
+
+    std::string_view title(size_t index) const;
+    std::string_view region(size_t index) const;
+    std::string_view version(size_t index) const;
+    std::string_view languages(size_t index) const;
+    std::string_view rating(size_t index) const;
+    std::string_view url(size_t index) const;
+    Game game(size_t index) const;
+
+    // Heap held by the pool, the columns and the intern table.
+    size_t bytesUsed() const;
+
+private:
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    Span store(std::string_view text);
+    uint16_t intern(std::string_view text);
+    void growValueSlots();
+    std::string_view view(Span span) const;
+
+    std::string pool;
+    std::vector<Span> titles;
+    std::vector<Span> urls;
+    std::vector<uint16_t> regions;
+    std::vector<uint16_t> versions;
+    std::vector<uint16_t> languageSets;
+    std::vector<uint16_t> ratings;
+    std::vector<Span> values; // interned strings by id; id 0 is ""
+    std::vector<uint16_t> valueSlots; // ids by hash, a power of two long; 0 is free
+};
+
+#endif // GAME_LIST_H
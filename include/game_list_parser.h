@@ -0,0 +1,41 @@
+#ifndef GAME_LIST_PARSER_H
+#define GAME_LIST_PARSER_H
+
+#include <functional>
+#include <string>
+#include <libxml/HTMLparser.h>
+#include "types.h"
+
+// Incremental counterpart of parseGamesHTML(): page bytes are pushed in as
+// they arrive and every <tr> that has a linked cell is emitted as soon as
+// the row closes, without building a DOM.
+class GameListParser {
+public:
+    explicit GameListParser(std::function<void(const Game&)> onGame);
+    ~GameListParser();
+
+    bool feed(const char* data, size_t size);
+    bool finish();
+    size_t rowCount() const;
+
+private:
+    static void startElement(void* ctx, const xmlChar* name, const xmlChar** attrs);
+    static void endElement(void* ctx, const xmlChar* name);
+    static void characters(void* ctx, const xmlChar* text, int length);
+
+    void beginRow();
+    void endRow();
+
+    std::function<void(const Game&)> onGame;
+    htmlParserCtxtPtr ctxt;
+    size_t rows;
+
+    bool inRow;
+    bool rowHasLink;
+    int cell;       // index of the current <td> in the row, -1 outside cells
+    int cellDepth;  // element nesting below the current <td>
+    bool inLink;
+    Game game;
+};
+
+#endif // GAME_LIST_PARSER_H
@@ -0,0 +1,48 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <unordered_map>
+
+// All Latin-1 glyphs of a font rasterized once into a single texture page.
+// Strings are drawn as one textured quad per glyph from that page, so the
+// cost of text no longer includes TTF rasterization or texture uploads.
+class GlyphAtlas {
+public:
+    GlyphAtlas();
+    ~GlyphAtlas();
+
+    bool build(SDL_Renderer* renderer, TTF_Font* font);
+    void destroy();
+    bool ready() const;
+
+    void draw(const std::string& text, int x, int y, SDL_Color color);
+    int measure(const std::string& text);
+    int height() const;
+
+private:
+    struct Glyph {
+        bool present = false;
+        SDL_Rect src = {0, 0, 0, 0};
+        int advance = 0;
+    };
+
+    static const int FIRST_GLYPH = 32;
+    static const int GLYPH_COUNT = 256;
+    static const int PAGE_WIDTH = 512;
+    static const size_t MAX_CACHED_WIDTHS = 2048;
+
+    Uint16 nextCodepoint(const std::string& text, size_t& pos) const;
+    int kerning(Uint16 previous, Uint16 current) const;
+
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    SDL_Texture* texture;
+    int lineHeight;
+    Glyph glyphs[GLYPH_COUNT];
+    std::unordered_map<std::string, int> widthCache;
+};
+
+#endif // GLYPH_ATLAS_H
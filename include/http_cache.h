@@ -0,0 +1,61 @@
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "http_client.h"
+
+// Disk-backed cache for catalog pages. A cached body is returned straight
+// away and revalidated in the background with If-None-Match /
+// If-Modified-Since on one worker thread; concurrent fetches of the same
+// URL share one request.
+// A chunk callback sees the body while it downloads, or all at once when it
+// is served from the cache. Revalidation and prefetches use the bulk lane,
+// so only pages the user asked for compete with downloads as interactive.
+class HttpCache {
+public:
+    static HttpCache& instance();
+
+    explicit HttpCache(const std::string& directory);
+    ~HttpCache();
+
+    ResponseBody fetch(const std::string& url, const ChunkCallback& onChunk = nullptr, TransferLane lane = TransferLane::Interactive);
+    bool lookup(const std::string& url, ResponseBuffer& body);
+    void store(const std::string& url, const std::string& etag, const std::string& lastModified, const ResponseBuffer& body);
+
+private:
+    struct Result {
+        bool complete;
+        ResponseBody body;
+    };
+
+    struct Entry {
+        std::string etag;
+        std::string lastModified;
+    };
+
+    std::string pathFor(const std::string& url) const;
+    bool readEntry(const std::string& url, Entry& entry);
+    Result download(const std::string& url, const ChunkCallback& onChunk, TransferLane lane);
+    void revalidate(const std::string& url);
+    void revalidateLoop();
+
+    std::string directory;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_future<Result>> inflight;
+    std::unordered_set<std::string> revalidated;
+    std::deque<std::string> staleUrls;
+    std::condition_variable staleCv;
+    std::thread revalidator;
+    std::atomic<bool> stopping;
+    std::atomic<unsigned> tmpCounter;
+};
+
+#endif // HTTP_CACHE_H
@@ -0,0 +1,64 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "curl_api.h"
+#include "response_buffer.h"
+#include "transfer_scheduler.h"
+
+struct HttpResponse {
+    int error = CURLE_OK;
+    long status = 0;
+    long long contentLength = -1;
+    std::string etag;
+    std::string lastModified;
+    ResponseBuffer body; // only filled by HttpClient::get()
+};
+
+// Receives body bytes as they arrive; returning false aborts the transfer.
+typedef std::function<bool(const char* data, size_t size)> ChunkCallback;
+
+// Process-wide libcurl session. Symbols are resolved once, easy handles are
+// pooled and every handle is attached to one share object, so DNS results,
+// TLS sessions and open connections to vimm.net survive between requests
+// issued from the UI and download threads.
+class HttpClient {
+public:
+    static HttpClient& instance();
+
+    bool available() const;
+    CurlApi& api();
+
+    CURL* acquire();
+    void release(CURL* handle);
+
+    // Collects the body, sized from Content-Length when the server sends
+    // one; onChunk, when set, also sees the bytes as they arrive.
+    HttpResponse get(const std::string& url, const std::vector<std::string>& headers = {},
+                     TransferLane lane = TransferLane::Interactive, const ChunkCallback& onChunk = nullptr);
+    HttpResponse stream(const std::string& url, const ChunkCallback& onChunk, const std::vector<std::string>& headers = {},
+                        TransferLane lane = TransferLane::Interactive);
+
+private:
+    HttpClient();
+    ~HttpClient();
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    HttpResponse perform(const std::string& url, const ChunkCallback& onChunk, const std::vector<std::string>& headers,
+                         TransferLane lane, bool collect);
+    static void lockShare(CURL* handle, int data, int access, void* userptr);
+    static void unlockShare(CURL* handle, int data, void* userptr);
+
+    CurlApi curl;
+    bool loaded;
+    CURLSH* share;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+    std::mutex poolMutex;
+    std::vector<CURL*> idleHandles;
+};
+
+#endif // HTTP_CLIENT_H
@@ -0,0 +1,56 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <SDL.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "renderer.h"
+
+// The paged two-column list used for consoles, letters and games. Only the
+// page holding the selection is drawn, and each of its rows is rasterized
+// once into a texture that is reused until a different label lands in that
+// slot. The selected row's marquee is one texture of the full label that a
+// source rect slides across, so a frame costs the same for any list or
+// title length.
+class ListView {
+public:
+    typedef std::function<std::string_view(size_t index)> LabelFunction;
+
+    static const int PAGE_SIZE = 40;
+
+    explicit ListView(Renderer& renderer);
+    ~ListView();
+
+    void draw(size_t count, const LabelFunction& label, size_t selected, int scrollOffset);
+    void clear();
+    bool scrolling() const;
+
+private:
+    struct Row {
+        std::string text;
+        SDL_Texture* texture = nullptr;
+        int w = 0;
+        int h = 0;
+    };
+
+    static const int ROWS_PER_COLUMN = 20;
+    static const int COLUMN_WIDTH = 250;
+    static const int ROW_HEIGHT = 30;
+    static const int ORIGIN = 50;
+    static const size_t MAX_LABEL = 20;
+    static const int MARQUEE_WIDTH = 380;
+    static const char* const MARQUEE_GAP;
+
+    static void release(Row& row);
+    void build(Row& row, std::string_view text, bool full);
+    void drawMarquee(int x, int y, std::string_view text, int scrollOffset, SDL_Color color);
+
+    Renderer& renderer;
+    Row rows[PAGE_SIZE];
+    Row marquee;
+    int marqueeStep;
+    bool marqueeScrolls;
+};
+
+#endif // LIST_VIEW_H
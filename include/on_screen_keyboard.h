@@ -0,0 +1,41 @@
+#ifndef ON_SCREEN_KEYBOARD_H
+#define ON_SCREEN_KEYBOARD_H
+
+#include <string>
+#include <vector>
+
+// A grid of keys walked with the d-pad. It only tracks the cursor and the
+// text typed so far; UIManager::drawSearch() draws it.
+class OnScreenKeyboard {
+public:
+    enum class Action {
+        None,
+        Typed,
+        Deleted,
+        Done
+    };
+
+    OnScreenKeyboard();
+
+    void move(int dx, int dy);
+    Action press();
+    bool backspace();
+    void clear();
+
+    const std::string& text() const;
+    const std::vector<std::string>& rows() const;
+    int row() const;
+    int column() const;
+
+    static const char SPACE_KEY = '_';
+    static const char DELETE_KEY = '<';
+    static const char DONE_KEY = '>';
+
+private:
+    std::vector<std::string> keys;
+    int cursorRow;
+    int cursorColumn;
+    std::string typed;
+};
+
+#endif // ON_SCREEN_KEYBOARD_H
@@ -0,0 +1,98 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Write path for downloads to the SD card. The file is preallocated in one
+// piece, so it does not fragment as it grows, after checking that it will
+// fit. Data is gathered into large page-aligned buffers and a write-behind
+// thread puts full buffers on the card, so the network threads go back to
+// receiving while the card is busy. Each sequential stream into the file
+// (one per download segment) is a channel with a buffer of its own; only
+// one thread may write to a given channel. The write-behind thread keeps a
+// running CRC-32 of what each channel has put in the file, so a download is
+// checked without reading it back.
+class OutputWriter {
+public:
+    struct Stats {
+        long long bytesWritten = 0;
+        long long flushes = 0;
+        double flushMsTotal = 0;
+        double flushMsMax = 0;
+    };
+
+    OutputWriter();
+    ~OutputWriter();
+
+    bool open(const std::string& path, long long expectedSize, bool truncate);
+    bool close();
+    bool isOpen() const;
+
+    // crc is the CRC-32 of the bytes already in the file before offset that
+    // belong to this stream (0 for a new one).
+    int channel(long long offset, uint32_t crc = 0);
+    bool write(int channel, const char* data, size_t size);
+    void seek(int channel, long long offset);
+    // File offset up to which the channel's data has reached the file, and
+    // the CRC-32 of that data since the channel was opened or last seeked.
+    long long durable(int channel);
+    long long durable(int channel, uint32_t& crc);
+
+    bool flush();
+    // fdatasync of what the write-behind thread has written so far.
+    bool sync();
+    bool truncate(long long length);
+
+    const std::string& error() const;
+    Stats stats();
+    static Stats totals();
+
+    // False, with a message in error, when the filesystem holding path has
+    // less than bytes available.
+    static bool checkFreeSpace(const std::string& path, long long bytes, std::string& error);
+
+private:
+    struct Buffer {
+        char* data = nullptr;
+        size_t fill = 0;
+        long long offset = 0;
+        int channel = -1;
+    };
+
+    struct Channel {
+        long long position = 0;
+        Buffer* buffer = nullptr;
+        std::atomic<long long> durable{0};
+        uint32_t crc = 0; // written by the write-behind thread under mutex
+    };
+
+    Buffer* takeBuffer();
+    void submit(Buffer* buffer);
+    void writeBehind();
+    bool fail(const std::string& message);
+
+    int fd;
+    std::string path;
+    std::string errorMessage;
+    std::atomic<bool> failed;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Buffer*> queue;
+    std::vector<Buffer*> freeBuffers;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::vector<std::unique_ptr<Channel>> channels;
+    int writing;
+    bool stopping;
+    Stats counters;
+    std::thread thread;
+};
+
+#endif // OUTPUT_WRITER_H
@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 #include "theme.h"
+#include "glyph_atlas.h"
+#include "texture_cache.h"
 #include "types.h"
 
 class Renderer {
@@ -17,15 +19,39 @@ public:
     void clear();
     void present();
     void drawText(const std::string& text, int x, int y, SDL_Color color);
+    int measureText(const std::string& text);
+    // Rasterizes text into a texture of its own, in white so that one
+    // texture can be drawn in any colour. The caller destroys it.
+    SDL_Texture* createTextTexture(const std::string& text, int& w, int& h);
+    void drawTexture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, SDL_Color color);
     void drawRoundedRect(SDL_Rect rect, int radius, int thickness);
-    void drawProgressBar(int progress, const std::string& title, const std::vector<std::string>& queuedTitles);
+    void drawFrame(const std::vector<SDL_Rect>& panels, int radius, int thickness);
+    void invalidateFrame();
+    void drawProgressBar(int progress, const std::string& title, int row);
     void drawImage(const std::string& imagePath, SDL_Rect rect);
+    bool drawCachedImage(const std::string& key, SDL_Rect rect);
     void drawMessageBox(const std::string& message);
+    void toggleOverlay();
+    bool overlayVisible() const;
+    void drawOverlay(const std::vector<std::string>& lines);
+    TextureCache& textures();
 
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     TTF_Font* font;
+    GlyphAtlas glyphAtlas;
+    TextureCache textureCache;
+    bool overlay;
+
+    // Background plus panel borders, rendered once per theme and layout.
+    SDL_Texture* frameTexture;
+    std::vector<SDL_Rect> framePanels;
+    int frameRadius;
+    int frameThickness;
+    unsigned int frameThemeGeneration;
+    int frameWidth;
+    int frameHeight;
 };
 
 #endif // RENDERER_H
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef RESPONSE_BUFFER_H
+#define RESPONSE_BUFFER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Recycles the blocks behind ResponseBuffers, so fetching page after page
+// reuses the same few allocations. Freed blocks are kept up to
+// RESPONSE_POOL_BYTES in total.
+class BufferPool {
+public:
+    struct Block {
+        char* data = nullptr;
+        size_t capacity = 0;
+        size_t size = 0;
+    };
+
+    static BufferPool& instance();
+
+    Block acquire(size_t minimum);
+    void release(Block& block);
+
+    size_t allocations();
+    size_t reuses();
+
+private:
+    BufferPool();
+    ~BufferPool();
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    std::mutex mutex;
+    std::vector<Block> freeBlocks;
+    size_t pooledBytes;
+    size_t allocationCount;
+    size_t reuseCount;
+};
+
+// An HTTP body as it arrived. With a Content-Length the whole body goes into
+// one block reserved up front; otherwise it grows by RESPONSE_SEGMENT_SIZE
+// segments instead of reallocating and copying what is already there.
+// Parsers read the segments in place (see readHtml()).
+class ResponseBuffer {
+public:
+    ResponseBuffer();
+    ~ResponseBuffer();
+    ResponseBuffer(ResponseBuffer&& other) noexcept;
+    ResponseBuffer& operator=(ResponseBuffer&& other) noexcept;
+    ResponseBuffer(const ResponseBuffer&) = delete;
+    ResponseBuffer& operator=(const ResponseBuffer&) = delete;
+
+    // Only takes effect before the first append.
+    void reserve(size_t bytes);
+    void append(const char* data, size_t size);
+    bool readFile(const std::string& path);
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+    // One segment: data() is the whole body.
+    bool contiguous() const;
+    const char* data() const;
+    size_t segmentCount() const;
+    const char* segmentData(size_t index) const;
+    size_t segmentSize(size_t index) const;
+    std::string str() const;
+
+private:
+    std::vector<BufferPool::Block> blocks;
+    size_t total;
+};
+
+// Bodies handed out by HttpCache, shared between concurrent fetches.
+typedef std::shared_ptr<const ResponseBuffer> ResponseBody;
+
+#endif // RESPONSE_BUFFER_H
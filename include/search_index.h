@@ -0,0 +1,52 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CatalogIndex;
+
+struct SearchHit {
+    uint32_t catalog; // position in the list given to build()
+    uint32_t record;
+};
+
+// Trigram index over game titles for fuzzy, as-you-type search, built from
+// one or more console catalogs. Titles are folded to lowercase letters and
+// digits; each one is split into padded trigrams stored as sorted posting
+// lists. A query scores titles by shared trigrams and ranks exact substring
+// and word-prefix matches first.
+class SearchIndex {
+public:
+    SearchIndex();
+
+    void build(const std::vector<const CatalogIndex*>& catalogs);
+    void clear();
+    size_t size() const;
+
+    // Best match first.
+    std::vector<SearchHit> query(const std::string& text, size_t limit);
+    // Matches found by the last query, including those past its limit.
+    size_t matchCount() const;
+
+    static std::string normalize(const std::string& text);
+
+private:
+    static void trigrams(const std::string& normalized, std::vector<uint32_t>& out);
+    int rank(uint32_t id, const std::string& needle, int shared, int total) const;
+
+    std::vector<std::string> titles;      // normalized, one per entry
+    std::vector<SearchHit> entries;
+    std::vector<uint32_t> keys;           // distinct trigrams, sorted
+    std::vector<uint32_t> postingOffsets; // keys.size() + 1 entries into postings
+    std::vector<uint32_t> postings;
+    std::vector<uint16_t> hits;           // per-title scratch for query()
+    std::vector<uint32_t> touched;
+
+    size_t lastMatches;
+    std::string lastQuery;
+    std::vector<uint32_t> lastCandidates;
+};
+
+#endif // SEARCH_INDEX_H
@@ -0,0 +1,93 @@
+#ifndef SEGMENTED_DOWNLOAD_H
+#define SEGMENTED_DOWNLOAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "curl_api.h"
+#include "output_writer.h"
+
+class HttpClient;
+
+// Bytes written so far and the expected total (0 when unknown). Called from
+// the transfer threads; returning false aborts the download, keeping the
+// .part file for a later resume.
+typedef std::function<bool(long long done, long long total)> ProgressCallback;
+
+struct DownloadProbe {
+    long long contentLength = -1;
+    bool acceptRanges = false;
+    std::string filename;
+    std::string etag;
+    std::string lastModified;
+};
+
+// Fetches one URL over several parallel ranged connections into a
+// preallocated file (through an OutputWriter), falling back to a single stream when the server
+// does not honour byte ranges. Data lands in "<outputPath>.part"; a
+// "<outputPath>.part.meta" sidecar records the validators, and the committed
+// bytes and their CRC-32 per segment, so an interrupted download continues
+// where it stopped and can still be checked as a whole.
+class SegmentedDownload {
+public:
+    SegmentedDownload(HttpClient& http, const std::string& url, const std::vector<std::string>& headers);
+    ~SegmentedDownload();
+
+    bool probe();
+    int run(const std::string& outputPath, int segmentCount, const ProgressCallback& onProgress);
+    const DownloadProbe& info() const;
+    bool aborted() const;
+    // CRC-32 of the finished file, put together from the segments' CRCs.
+    uint32_t checksum() const;
+
+private:
+    struct Segment {
+        SegmentedDownload* owner = nullptr;
+        long long start = 0;
+        long long end = -1; // inclusive, -1 when the length is unknown
+        bool ranged = false;
+        bool rejected = false;
+        long status = 0; // of the current attempt, from its status line
+        std::atomic<long long> written{0};
+        long long streamTotal = 0;
+        int channel = -1;
+        uint32_t crc = 0; // of the committed bytes, when loaded from the sidecar
+    };
+
+    void buildHeaderList();
+    bool loadPartState(const std::string& partPath);
+    void commit(bool force = true);
+    bool fetchSegment(Segment& segment);
+    bool runSegments(int segmentCount);
+    void reportProgress(const Segment& segment);
+    long long bytesWritten() const;
+
+    static size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t headerCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t probeWriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t probeHeaderCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static int progressCallback(void* userdata, curl_off_t total, curl_off_t now, curl_off_t, curl_off_t);
+
+    HttpClient& http;
+    CurlApi& curl;
+    std::string url;
+    std::vector<std::string> headers;
+    struct curl_slist* headerList;
+    DownloadProbe probeInfo;
+    std::vector<std::unique_ptr<Segment>> segments;
+    ProgressCallback onProgress;
+    std::atomic<bool> abortRequested;
+    OutputWriter writer;
+    std::string partPath;
+    std::mutex commitMutex;
+    std::atomic<long long> committedBytes;
+    uint32_t fileCrc;
+};
+
+bool parseHeaderLine(const std::string& line, const std::string& name, std::string& value);
+
+#endif // SEGMENTED_DOWNLOAD_H
@@ -0,0 +1,55 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <SDL.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// Decoded images as textures, keyed by path and target size. Entries are
+// dropped least-recently-used first once the byte budget is exceeded.
+// Only touch it from the render thread.
+class TextureCache {
+public:
+    explicit TextureCache(size_t budgetBytes);
+    ~TextureCache();
+
+    void setRenderer(SDL_Renderer* renderer);
+
+    SDL_Texture* get(const std::string& path, int w, int h);
+    bool preload(const std::string& path, int w, int h);
+    // Looks up without loading from disk on a miss.
+    SDL_Texture* find(const std::string& path, int w, int h);
+    // Uploads a surface decoded elsewhere under path; takes ownership of it.
+    SDL_Texture* adopt(const std::string& path, int w, int h, SDL_Surface* surface);
+    void evict(const std::string& path);
+    void clear();
+
+    size_t hits() const;
+    size_t misses() const;
+    size_t bytesUsed() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::string path;
+        SDL_Texture* texture;
+        size_t bytes;
+    };
+
+    static std::string keyFor(const std::string& path, int w, int h);
+    SDL_Texture* load(const std::string& path, int w, int h, size_t& bytes);
+    SDL_Texture* insert(const std::string& path, int w, int h);
+    void add(const std::string& path, int w, int h, SDL_Texture* texture, size_t bytes);
+    void trim();
+
+    SDL_Renderer* renderer;
+    size_t budget;
+    size_t used;
+    size_t hitCount;
+    size_t missCount;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+};
+
+#endif // TEXTURE_CACHE_H
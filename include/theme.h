@@ -12,6 +12,8 @@ struct Theme {
 };
 
 extern Theme currentTheme;
+// Bumped whenever the palette actually changes, so cached drawings know to rebuild.
+extern unsigned int themeGeneration;
 
 void applyTheme(const Theme& theme);
 
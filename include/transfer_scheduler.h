@@ -0,0 +1,66 @@
+#ifndef TRANSFER_SCHEDULER_H
+#define TRANSFER_SCHEDULER_H
+
+#include <chrono>
+#include <mutex>
+
+enum class TransferLane {
+    Interactive, // pages and artwork the user is waiting for
+    Bulk         // ROM payloads, prefetches, revalidation and crawling
+};
+
+// Shares the link between transfers. Every received chunk is charged to a
+// token bucket for its lane and to a global one; throttle() then sleeps in
+// the curl write callback until the buckets are out of debt, which stalls
+// the socket and lets TCP slow the sender down. Interactive transfers are
+// never held back by the global cap, only charged to it, so a page load
+// takes its bandwidth out of the bulk lane. With no cap set, bulk is held
+// to a share of its earlier rate while interactive transfers are running.
+// Limits are in bytes per second, 0 meaning unlimited, and can be changed
+// at any time.
+class TransferScheduler {
+public:
+    static TransferScheduler& instance();
+
+    void setLimit(TransferLane lane, long long bytesPerSecond);
+    void setGlobalLimit(long long bytesPerSecond);
+    long long limit(TransferLane lane) const;
+    long long globalLimit() const;
+
+    void begin(TransferLane lane);
+    void end(TransferLane lane);
+    void throttle(TransferLane lane, size_t bytes);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Bucket {
+        long long rate = 0;
+        double tokens = 0;
+        Clock::time_point refilled;
+
+        void setRate(long long bytesPerSecond, Clock::time_point now);
+        void refill(Clock::time_point now);
+        void charge(size_t bytes);
+        double waitSeconds() const;
+    };
+
+    TransferScheduler();
+    TransferScheduler(const TransferScheduler&) = delete;
+    TransferScheduler& operator=(const TransferScheduler&) = delete;
+
+    Bucket& bucket(TransferLane lane);
+    void measureBulk(size_t bytes, Clock::time_point now);
+
+    mutable std::mutex mutex;
+    Bucket interactive;
+    Bucket bulk;
+    Bucket global;
+    Bucket yield; // bulk's share while interactive transfers run
+    int interactiveActive;
+    double bulkRate;
+    long long bulkWindowBytes;
+    Clock::time_point bulkWindowStart;
+};
+
+#endif // TRANSFER_SCHEDULER_H
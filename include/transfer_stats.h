@@ -0,0 +1,49 @@
+#ifndef TRANSFER_STATS_H
+#define TRANSFER_STATS_H
+
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "curl_api.h"
+
+// Timings of one finished request as reported by curl, in seconds from the
+// start of the request (so connect includes the DNS lookup, and so on).
+struct TransferRecord {
+    std::string url;
+    time_t finished = 0;
+    int error = 0;
+    long status = 0;
+    double namelookup = 0;
+    double connect = 0;
+    double appconnect = 0;   // TLS handshake done; 0 for plain HTTP or a reused connection
+    double starttransfer = 0; // first byte of the response
+    double total = 0;
+    double bytesPerSecond = 0;
+    long long bytes = 0;
+};
+
+// Keeps the most recent transfers in a ring for the stats overlay and
+// appends every one as a line to a log file, so slow downloads can be
+// pinned on DNS, connect, TLS, the server or the link.
+class TransferStats {
+public:
+    static TransferStats& instance();
+
+    explicit TransferStats(const std::string& logPath);
+
+    void record(CurlApi& curl, CURL* handle, const std::string& url, int error);
+    std::vector<TransferRecord> recent() const;
+    double averageTimeToFirstByte() const;
+
+private:
+    void append(const TransferRecord& record);
+
+    std::string logPath;
+    mutable std::mutex mutex;
+    std::vector<TransferRecord> ring;
+    size_t next;
+    size_t count;
+};
+
+#endif // TRANSFER_STATS_H
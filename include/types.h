@@ -18,6 +18,12 @@ struct Console {
     std::string url;
 };
 
+// CRC-32 the vault publishes for a game's media, as lowercase hex; empty
+// when the detail page does not list one.
+struct MediaChecksums {
+    std::string crc32;
+};
+
 class Filter {
 public:
     std::string value;
@@ -4,7 +4,13 @@
 #include <string>
 #include <vector>
 #include "renderer.h"
+#include "download_manager.h"
+#include "extraction_queue.h"
+#include "on_screen_keyboard.h"
 #include "types.h"
+#include "game_list.h"
+#include "catalog_index.h"
+#include "list_view.h"
 
 class UIManager {
 public:
@@ -12,13 +18,23 @@ public:
     ~UIManager();
     void drawConsoleList(const std::vector<Console>& consoles, int selectedConsole, int scrollOffset);
     void drawFilterList(const std::vector<Filter>& filters, int selectedFilter, int scrollOffset);
-    void drawGameList(const std::vector<Game>& games, int selectedGame, int scrollOffset);
-    void drawProgressBar(int progress, const std::string& title, const std::vector<std::string>& queuedTitles);
+    void drawGameList(const GameList& games, int selectedGame, int scrollOffset);
+    void drawGameList(const CatalogIndex::Slice& games, int selectedGame, int scrollOffset);
+    int drawDownloads(const std::vector<DownloadItem>& items, int firstRow);
+    int drawExtractions(const std::vector<ExtractJob>& jobs, int firstRow);
+    int drawBandwidthCap(long long bytesPerSecond, int firstRow);
+    void drawStatsOverlay(const std::vector<DownloadItem>& items, double averageTtfb, double frameMs);
+    void drawLoadingIndicator(size_t rowsLoaded, int tick);
+    void drawSearch(const OnScreenKeyboard& keyboard, const std::string& scope, size_t resultCount, bool keyboardFocused);
+    bool marqueeScrolls() const;
 
 private:
     Renderer& renderer;
+    ListView consoleView;
+    ListView filterView;
+    ListView gameView;
+    const ListView* shownView;
     std::string shortenText(const std::string& text, int maxLength);
-    std::string scrollText(const std::string& text, int offset);
 };
 
 #endif // UI_MANAGER_H
\ No newline at end of file
@@ -3,27 +3,38 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include <iostream>
 #include <dlfcn.h>
 #include <libxml/HTMLparser.h>
 #include <libxml/xpath.h>
 #include "download_manager.h"
+#include "segmented_download.h"
 #include <regex>
 #include <fstream>
 
 
 #include "types.h"
-
-extern std::atomic<int> downloadProgress;
+#include "game_list.h"
+#include "response_buffer.h"
 
 size_t header_callback(void* ptr, size_t size, size_t nmemb, std::string* filename);
-std::string getHtml(const std::string& url);
-std::vector<Console> parseHTML(const std::string& html);
-std::vector<Game> parseGamesHTML(const std::string &htmlContent);
-int downloadGame(std::string console, const std::string &htmlContent);
-int unzipGames(::std::string console);
-
-void setDownloadManager(DownloadManager* manager);
+ResponseBuffer getHtml(const std::string& url);
+ResponseBody getCatalogHtml(const std::string& url);
+htmlDocPtr readHtml(const ResponseBuffer& html);
+std::vector<Console> parseHTML(const ResponseBuffer& html);
+GameList parseGamesHTML(const ResponseBuffer& htmlContent);
+int downloadGame(std::string console, const ResponseBuffer& htmlContent, const ProgressCallback& onProgress = nullptr,
+                 const std::function<void()>& onExtracting = nullptr, ExtractionQueue* extractionQueue = nullptr);
+std::string romPathFor(const std::string& console);
+MediaChecksums parseChecksums(const ResponseBuffer& htmlContent);
+std::string parseMediaId(const ResponseBuffer& htmlContent);
+
+// Number of parallel ranged connections per ROM download (default DOWNLOAD_SEGMENTS)
+void setDownloadSegments(int segments);
+
+// Keep the .zip/.7z next to the extracted files (default KEEP_ARCHIVES)
+void setKeepArchives(bool keep);
 
 
 
@@ -0,0 +1,73 @@
+#ifndef ZIP_STREAM_H
+#define ZIP_STREAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+// Unpacks a zip archive from its bytes in file order, as they come off the
+// network, without ever seeing the whole archive. Local file headers are
+// followed entry by entry (stored and deflated, with data descriptors and
+// zip64 sizes); the central directory at the end is not needed and is
+// skipped. Each entry is written to "<name>.part" and renamed once its
+// CRC-32 checks out. With an empty output directory nothing is written and
+// the archive is only verified.
+class ZipStream {
+public:
+    explicit ZipStream(const std::string& outputDir);
+    ~ZipStream();
+
+    bool feed(const char* data, size_t size);
+    bool finish();
+    void discard();
+
+    const std::vector<std::string>& files() const;
+    const std::string& error() const;
+
+private:
+    enum class Stage {
+        Signature,
+        Header,
+        Data,
+        Descriptor,
+        Done,
+        Failed
+    };
+
+    bool fail(const std::string& message);
+    bool need(const char*& data, size_t& size, size_t count);
+    bool parseHeader();
+    bool openEntry();
+    bool writeOut(const unsigned char* data, size_t size);
+    bool closeEntry(unsigned long expectedCrc);
+    size_t consumeStored(const char* data, size_t size);
+    size_t consumeDeflated(const char* data, size_t size);
+
+    std::string outputDir;
+    Stage stage;
+    std::string errorMessage;
+    std::vector<unsigned char> pending;
+    size_t pendingNeeded;
+    std::vector<std::string> written;
+
+    // Current entry
+    std::string name;
+    std::string partPath;
+    int fd;
+    unsigned int flags;
+    unsigned int method;
+    unsigned long headerCrc;
+    unsigned long long compressedSize;
+    unsigned long long remaining;
+    bool zip64;
+    bool entryFinished;
+    bool descriptorSized;
+    bool isFile;
+    uint32_t crc;
+    z_stream inflater;
+    bool inflaterReady;
+    std::vector<unsigned char> outBuffer;
+};
+
+#endif // ZIP_STREAM_H
@@ -0,0 +1,167 @@
+#include "artwork_loader.h"
+#include "http_client.h"
+#include <SDL_image.h>
+#include <algorithm>
+#include <iostream>
+
+ArtworkLoader::ArtworkLoader(WakeCallback wake, int workerCount)
+    : wake(wake), cache(CACHE_DIR "/art"), stopping(false) {
+    for (int i = 0; i < std::max(1, workerCount); i++) {
+        workers.emplace_back(&ArtworkLoader::worker, this);
+    }
+}
+
+ArtworkLoader::~ArtworkLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+        wantedUrls.clear();
+    }
+    cv.notify_all();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    for (auto& art : ready) {
+        SDL_FreeSurface(art.surface);
+    }
+}
+
+std::string ArtworkLoader::boxArtUrl(std::string_view gameUrl) {
+    // Game URLs look like "/vault/12345".
+    std::string id(gameUrl.substr(gameUrl.find_last_of('/') + 1));
+    return id.empty() ? "" : "https://vimm.net/image.php?type=box&id=" + id;
+}
+
+void ArtworkLoader::request(const std::string& selected, const std::vector<std::string>& prefetch, int w, int h) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+        wantedUrls.clear();
+        auto add = [&](const std::string& url, TransferLane lane) {
+            if (url.empty() || failedUrls.count(url)) {
+                return;
+            }
+            wantedUrls.insert(url);
+            // Already downloading for an earlier request: let it finish.
+            if (!inFlight.count(url)) {
+                queue.push_back({url, w, h, lane});
+            }
+        };
+        add(selected, TransferLane::Interactive);
+        for (const auto& url : prefetch) {
+            add(url, TransferLane::Bulk);
+        }
+    }
+    cv.notify_all();
+}
+
+void ArtworkLoader::cancel() {
+    request("", {}, 0, 0);
+}
+
+bool ArtworkLoader::drain(std::vector<Ready>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ready.empty()) {
+        return false;
+    }
+    out.insert(out.end(), ready.begin(), ready.end());
+    ready.clear();
+    return true;
+}
+
+bool ArtworkLoader::failed(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failedUrls.count(url) > 0;
+}
+
+bool ArtworkLoader::wanted(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !stopping && wantedUrls.count(url) > 0;
+}
+
+SDL_Surface* ArtworkLoader::decode(const ResponseBuffer& data, int w, int h) {
+    // Decoders want one block; only a body that arrived without a length is joined.
+    std::string joined = data.contiguous() ? "" : data.str();
+    SDL_Surface* image = joined.empty() ? IMG_Load_RW(SDL_RWFromConstMem(data.data(), data.size()), 1)
+                                        : IMG_Load_RW(SDL_RWFromConstMem(joined.data(), joined.size()), 1);
+    if (!image) {
+        return nullptr;
+    }
+    // Shrink to fit the box, keeping the aspect ratio; small art is left
+    // alone and scaled up by the GPU when drawn.
+    double scale = std::min(1.0, std::min((double)w / image->w, (double)h / image->h));
+    int targetW = std::max(1, (int)(image->w * scale));
+    int targetH = std::max(1, (int)(image->h * scale));
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(image);
+    if (!converted || (targetW == converted->w && targetH == converted->h)) {
+        return converted;
+    }
+    SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, targetW, targetH, 32, SDL_PIXELFORMAT_RGBA32);
+    if (scaled) {
+        SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(converted, nullptr, scaled, nullptr);
+    }
+    SDL_FreeSurface(converted);
+    return scaled;
+}
+
+void ArtworkLoader::process(const Job& job) {
+    ResponseBuffer data;
+    if (!cache.lookup(job.url, data)) {
+        HttpResponse response = HttpClient::instance().get(job.url, {}, job.lane, [this, &job](const char*, size_t) {
+            return wanted(job.url);
+        });
+        data = std::move(response.body);
+        if (response.error == CURLE_WRITE_ERROR && !wanted(job.url)) {
+            return; // abandoned; asked for again later if it comes back into view
+        }
+        // Only a missing image is remembered; anything else may work next time.
+        if (response.error == CURLE_OK && response.status == 404) {
+            std::lock_guard<std::mutex> lock(mutex);
+            failedUrls.insert(job.url);
+            return;
+        }
+        if (response.error != CURLE_OK || response.status != 200 || data.empty()) {
+            return;
+        }
+        cache.store(job.url, response.etag, response.lastModified, data);
+    }
+
+    SDL_Surface* surface = decode(data, job.w, job.h);
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!surface) {
+            std::cerr << "Failed to decode artwork " << job.url << ": " << IMG_GetError() << std::endl;
+            failedUrls.insert(job.url);
+        } else {
+            // Kept even if the selection moved on: it is done and will be cached.
+            notify = ready.empty();
+            ready.push_back({job.url, job.w, job.h, surface});
+        }
+    }
+    if (notify && wake) {
+        wake();
+    }
+}
+
+void ArtworkLoader::worker() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = queue.front();
+            queue.pop_front();
+            inFlight.insert(job.url);
+        }
+        process(job);
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight.erase(job.url);
+    }
+}
@@ -0,0 +1,195 @@
+#include "batch_download.h"
+#include "catalog_index.h"
+#include "download_manager.h"
+#include "search_index.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+struct BatchEntry {
+    int line;
+    std::string console;
+    std::string query;
+};
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+static bool readList(const std::string& listPath, std::vector<BatchEntry>& entries) {
+    std::ifstream in(listPath);
+    if (!in) {
+        std::cerr << "Cannot open batch list " << listPath << std::endl;
+        return false;
+    }
+    std::string text;
+    for (int line = 1; std::getline(in, text); line++) {
+        // Only a whole line is a comment: titles like "#1 Bandit" keep their '#'.
+        text = trim(text);
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+        size_t bar = text.find('|');
+        if (bar == std::string::npos) {
+            std::cerr << listPath << ":" << line << ": expected \"<console> | <title or id>\"" << std::endl;
+            entries.push_back({line, "", text});
+            continue;
+        }
+        entries.push_back({line, trim(text.substr(0, bar)), trim(text.substr(bar + 1))});
+    }
+    return true;
+}
+
+static const Console* findConsole(const std::vector<Console>& consoles, const std::string& name) {
+    std::string wanted = SearchIndex::normalize(name);
+    for (const auto& console : consoles) {
+        std::string code = console.url.substr(console.url.find_last_of('/') + 1);
+        if (SearchIndex::normalize(console.name) == wanted || SearchIndex::normalize(code) == wanted) {
+            return &console;
+        }
+    }
+    return nullptr;
+}
+
+static int letterFor(const std::string& title) {
+    unsigned char first = title.empty() ? '#' : toupper((unsigned char)title[0]);
+    return first >= 'A' && first <= 'Z' ? first - 'A' + 1 : 0;
+}
+
+// An exact match (ignoring case and punctuation) wins; otherwise the title
+// must be contained in exactly one game's title. Works on a GameList or an
+// index slice.
+template <typename List>
+static bool findTitle(const List& games, const Console& console, const std::string& title, Game& found) {
+    std::string wanted = SearchIndex::normalize(title);
+    size_t partial = 0;
+    int partialCount = 0;
+    for (size_t i = 0; i < games.size(); i++) {
+        std::string candidate = SearchIndex::normalize(std::string(games.title(i)));
+        if (candidate == wanted) {
+            found = games.game(i);
+            return true;
+        }
+        if (candidate.find(wanted) != std::string::npos) {
+            partial = i;
+            partialCount++;
+        }
+    }
+    if (partialCount == 1) {
+        found = games.game(partial);
+        return true;
+    }
+    if (partialCount > 1) {
+        std::cerr << "\"" << title << "\" matches " << partialCount << " games on " << console.name << "; be more specific" << std::endl;
+    }
+    return false;
+}
+
+// Looks the title up on its letter page, from the crawled index when there
+// is one.
+static bool resolveTitle(const Console& console, const std::string& title, Game& found) {
+    int letter = letterFor(title);
+    CatalogIndex index;
+    if (index.open(CatalogIndex::pathFor(console))) {
+        return findTitle(index.letter(letter), console, title, found);
+    }
+    GameList games = parseGamesHTML(*getCatalogHtml("https://vimm.net" + console.url + "/" + CatalogIndex::letterName(letter)));
+    return findTitle(games, console, title, found);
+}
+
+static std::string formatBytes(double bytes) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.1f MB", bytes / (1024 * 1024));
+    return buffer;
+}
+
+int runBatchDownload(const std::string& listPath) {
+    xmlInitParser();
+    LIBXML_TEST_VERSION
+    std::vector<BatchEntry> entries;
+    if (!readList(listPath, entries)) {
+        return 2;
+    }
+    std::vector<Console> consoles = parseHTML(*getCatalogHtml("https://vimm.net/vault"));
+    if (consoles.empty()) {
+        std::cerr << "Could not load the console list" << std::endl;
+        return 2;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    DownloadManager downloadManager;
+    int unresolved = 0;
+    for (const auto& entry : entries) {
+        const Console* console = entry.console.empty() ? nullptr : findConsole(consoles, entry.console);
+        if (!console) {
+            std::cerr << listPath << ":" << entry.line << ": unknown console \"" << entry.console << "\"" << std::endl;
+            unresolved++;
+            continue;
+        }
+        Game game;
+        if (!entry.query.empty() && std::all_of(entry.query.begin(), entry.query.end(), ::isdigit)) {
+            game.title = console->name + " #" + entry.query;
+            game.url = "/vault/" + entry.query;
+        } else if (!resolveTitle(*console, entry.query, game)) {
+            std::cerr << listPath << ":" << entry.line << ": no game \"" << entry.query << "\" on " << console->name << std::endl;
+            unresolved++;
+            continue;
+        }
+        downloadManager.queueDownload(console->name, "https://vimm.net" + game.url, game.title);
+    }
+
+    // Print each state change as it happens and a throughput line now and then.
+    std::vector<DownloadState> shown;
+    auto lastSummary = std::chrono::steady_clock::now();
+    while (downloadManager.busy()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(STATUS_POLL_MS));
+        std::vector<DownloadItem> items = downloadManager.snapshot();
+        shown.resize(items.size(), DownloadState::Queued);
+        double rate = 0;
+        for (size_t i = 0; i < items.size(); i++) {
+            rate += items[i].bytesPerSecond;
+            if (items[i].state != shown[i]) {
+                shown[i] = items[i].state;
+                printf("[%zu/%zu] %s: %s\n", i + 1, items.size(), items[i].title.c_str(), downloadStateName(items[i].state));
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastSummary >= std::chrono::milliseconds(BATCH_PROGRESS_INTERVAL_MS)) {
+            lastSummary = now;
+            for (size_t i = 0; i < items.size(); i++) {
+                if (items[i].state == DownloadState::Downloading) {
+                    int percent = items[i].bytesTotal > 0 ? (int)(items[i].bytesDone * 100 / items[i].bytesTotal) : 0;
+                    printf("[%zu/%zu] %s: %d%% of %s\n", i + 1, items.size(), items[i].title.c_str(), percent,
+                           formatBytes(items[i].bytesTotal).c_str());
+                }
+            }
+            printf("Throughput: %s/s\n", formatBytes(rate).c_str());
+        }
+        fflush(stdout);
+    }
+
+    int done = 0, failed = 0;
+    double bytes = 0;
+    for (const auto& item : downloadManager.snapshot()) {
+        if (item.state == DownloadState::Done) {
+            done++;
+            bytes += item.bytesDone;
+        } else {
+            failed++;
+            printf("Failed: %s\n", item.title.c_str());
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    printf("Batch finished: %d downloaded, %d failed, %d not resolved; %s in %.0f s (%s/s)\n", done, failed, unresolved,
+           formatBytes(bytes).c_str(), seconds, formatBytes(seconds > 0 ? bytes / seconds : 0).c_str());
+    return failed == 0 && unresolved == 0 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "catalog_index.h"
+#include "config.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char INDEX_MAGIC[8] = {'O', 'C', 'T', 'O', 'I', 'D', 'X', '1'};
+static const uint32_t INDEX_VERSION = 1;
+
+CatalogIndex::CatalogIndex() : mapping(nullptr), mappingSize(0), header(nullptr), records(nullptr), pool(nullptr) {}
+
+CatalogIndex::~CatalogIndex() {
+    close();
+}
+
+std::string CatalogIndex::letterName(int letter) {
+    return letter == 0 ? "#" : std::string(1, (char)('A' + letter - 1));
+}
+
+std::string CatalogIndex::pathFor(const Console& console) {
+    // Console URLs look like "/vault/NES"; the last segment names the file.
+    std::string name = console.url.substr(console.url.find_last_of('/') + 1);
+    if (name.empty()) {
+        name = console.name;
+    }
+    return std::string(CACHE_DIR) + "/index/" + name + ".idx";
+}
+
+bool CatalogIndex::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Only the layout is checked here, so opening stays O(1) in the number
+    // of records; string() bounds each offset as it is read.
+    const Header* candidate = static_cast<const Header*>(mapped);
+    size_t recordsEnd = sizeof(Header) + (size_t)candidate->recordCount * sizeof(Record);
+    bool valid = memcmp(candidate->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 && candidate->version == INDEX_VERSION &&
+                 recordsEnd <= (size_t)st.st_size && recordsEnd + candidate->poolSize == (size_t)st.st_size &&
+                 candidate->poolSize > 0 && static_cast<const char*>(mapped)[st.st_size - 1] == '\0' &&
+                 candidate->letterOffsets[LETTER_COUNT] == candidate->recordCount;
+    for (int i = 0; valid && i < LETTER_COUNT; i++) {
+        valid = candidate->letterOffsets[i] <= candidate->letterOffsets[i + 1];
+    }
+    const Record* candidateRecords = reinterpret_cast<const Record*>(static_cast<const char*>(mapped) + sizeof(Header));
+    if (!valid) {
+        std::cerr << "Ignoring invalid catalog index " << path << std::endl;
+        munmap(mapped, st.st_size);
+        return false;
+    }
+
+    mapping = mapped;
+    mappingSize = st.st_size;
+    header = candidate;
+    records = candidateRecords;
+    pool = static_cast<const char*>(mapped) + recordsEnd;
+    return true;
+}
+
+void CatalogIndex::close() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    records = nullptr;
+    pool = nullptr;
+}
+
+bool CatalogIndex::isOpen() const {
+    return header != nullptr;
+}
+
+size_t CatalogIndex::size() const {
+    return header ? header->recordCount : 0;
+}
+
+size_t CatalogIndex::letterBegin(int letter) const {
+    return header && letter >= 0 && letter < LETTER_COUNT ? header->letterOffsets[letter] : 0;
+}
+
+size_t CatalogIndex::letterEnd(int letter) const {
+    return header && letter >= 0 && letter < LETTER_COUNT ? header->letterOffsets[letter + 1] : 0;
+}
+
+const char* CatalogIndex::string(uint32_t offset) const {
+    // The pool ends in a NUL, so any offset inside it is a terminated
+    // string; one outside it (a damaged file) reads as empty.
+    return offset < header->poolSize ? pool + offset : "";
+}
+
+const char* CatalogIndex::title(size_t index) const {
+    return string(records[index].title);
+}
+
+const char* CatalogIndex::url(size_t index) const {
+    return string(records[index].url);
+}
+
+Game CatalogIndex::game(size_t index) const {
+    const Record& r = records[index];
+    Game game;
+    game.title = string(r.title);
+    game.region = string(r.region);
+    game.version = string(r.version);
+    game.languages = string(r.languages);
+    game.rating = string(r.rating);
+    game.url = string(r.url);
+    return game;
+}
+
+CatalogIndex::Slice CatalogIndex::letter(int letter) const {
+    return Slice(this, letterBegin(letter), letterEnd(letter));
+}
+
+CatalogIndex::Slice::Slice() : index(nullptr), begin(0), end(0) {}
+
+CatalogIndex::Slice::Slice(const CatalogIndex* index, size_t begin, size_t end) : index(index), begin(begin), end(end) {}
+
+size_t CatalogIndex::Slice::size() const {
+    return end - begin;
+}
+
+bool CatalogIndex::Slice::empty() const {
+    return begin == end;
+}
+
+std::string_view CatalogIndex::Slice::title(size_t i) const {
+    return index->title(begin + i);
+}
+
+std::string_view CatalogIndex::Slice::url(size_t i) const {
+    return index->url(begin + i);
+}
+
+Game CatalogIndex::Slice::game(size_t i) const {
+    return index->game(begin + i);
+}
+
+bool CatalogIndex::write(const std::string& path, const std::vector<GameList>& letters) {
+    Header header = {};
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+
+    // Regions, languages and ratings repeat on almost every row, so every
+    // string is interned and stored once.
+    std::string pool(1, '\0');
+    std::unordered_map<std::string, uint32_t> interned = {{"", 0}};
+    auto intern = [&pool, &interned](std::string_view view) {
+        std::string text(view.substr(0, view.find('\0')));
+        auto it = interned.find(text);
+        if (it != interned.end()) {
+            return it->second;
+        }
+        uint32_t offset = pool.size();
+        pool.append(text.c_str(), text.size() + 1);
+        interned.emplace(text, offset);
+        return offset;
+    };
+
+    std::vector<Record> records;
+    for (int letter = 0; letter < LETTER_COUNT; letter++) {
+        header.letterOffsets[letter] = records.size();
+        if (letter >= (int)letters.size()) {
+            continue;
+        }
+        const GameList& games = letters[letter];
+        for (size_t i = 0; i < games.size(); i++) {
+            records.push_back({intern(games.title(i)), intern(games.region(i)), intern(games.version(i)),
+                               intern(games.languages(i)), intern(games.rating(i)), intern(games.url(i))});
+        }
+    }
+    header.letterOffsets[LETTER_COUNT] = records.size();
+    header.recordCount = records.size();
+    header.poolSize = pool.size();
+
+    std::string directory = path.substr(0, path.find_last_of('/'));
+    mkdir(directory.c_str(), 0755);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+        out.write(pool.data(), pool.size());
+        if (!out) {
+            std::cerr << "Failed to write catalog index " << tmpPath << std::endl;
+            unlink(tmpPath.c_str());
+            return false;
+        }
+    }
+    return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
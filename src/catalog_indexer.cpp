@@ -0,0 +1,75 @@
+#include "catalog_indexer.h"
+#include "catalog_index.h"
+#include "game_list_parser.h"
+#include "http_client.h"
+#include "config.h"
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <sys/stat.h>
+
+CatalogIndexer::CatalogIndexer(const std::vector<Console>& consoles, IndexedCallback onIndexed)
+    : consoles(consoles), onIndexed(onIndexed), stopping(false) {
+    worker = std::thread(&CatalogIndexer::run, this);
+}
+
+CatalogIndexer::~CatalogIndexer() {
+    stopping = true;
+    worker.join();
+}
+
+bool CatalogIndexer::fresh(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && time(nullptr) - st.st_mtime < CATALOG_INDEX_MAX_AGE;
+}
+
+bool CatalogIndexer::crawl(const Console& console) {
+    HttpClient& http = HttpClient::instance();
+    std::vector<GameList> letters(CatalogIndex::LETTER_COUNT);
+    for (int letter = 0; letter < CatalogIndex::LETTER_COUNT; letter++) {
+        std::string url = "https://vimm.net" + console.url + "/" + CatalogIndex::letterName(letter);
+        GameListParser parser([&letters, letter](const Game& game) {
+            letters[letter].add(game);
+        });
+        HttpResponse response = http.stream(url, [this, &parser](const char* data, size_t size) {
+            return !stopping && parser.feed(data, size);
+        }, {}, TransferLane::Bulk);
+        if (stopping || response.error != CURLE_OK || response.status != 200) {
+            return false;
+        }
+        parser.finish();
+
+        // Spread the requests out; this competes with the user's own browsing.
+        for (int waited = 0; waited < CATALOG_CRAWL_DELAY_MS && !stopping; waited += 50) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+    size_t total = 0;
+    for (const auto& games : letters) {
+        total += games.size();
+    }
+    if (!CatalogIndex::write(CatalogIndex::pathFor(console), letters)) {
+        return false;
+    }
+    std::cout << "Indexed " << console.name << ": " << total << " games" << std::endl;
+    return true;
+}
+
+void CatalogIndexer::run() {
+    for (const auto& console : consoles) {
+        if (stopping) {
+            return;
+        }
+        if (fresh(CatalogIndex::pathFor(console))) {
+            continue;
+        }
+        if (crawl(console)) {
+            if (onIndexed) {
+                onIndexed(console);
+            }
+        } else if (!stopping) {
+            std::cerr << "Failed to index " << console.name << std::endl;
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#include "catalog_loader.h"
+#include "game_list_parser.h"
+#include "http_cache.h"
+#include <iostream>
+
+CatalogLoader::CatalogLoader(WakeCallback wake)
+    : wake(wake), generation(0), stopping(false), hasRequest(false), busy(false) {
+    worker = std::thread(&CatalogLoader::run, this);
+}
+
+CatalogLoader::~CatalogLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        generation++;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+void CatalogLoader::load(const std::string& url, const std::vector<std::string>& prefetchUrls) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        request = {url, prefetchUrls};
+        hasRequest = true;
+        busy = true;
+        rows.clear();
+        prefetchQueue.clear();
+    }
+    cv.notify_one();
+}
+
+void CatalogLoader::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation++;
+    hasRequest = false;
+    busy = false;
+    rows.clear();
+    prefetchQueue.clear();
+}
+
+bool CatalogLoader::drain(GameList& games) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rows.empty()) {
+        return false;
+    }
+    if (games.empty()) {
+        std::swap(games, rows);
+    } else {
+        games.append(rows);
+    }
+    rows.clear();
+    return true;
+}
+
+bool CatalogLoader::loading() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return busy;
+}
+
+void CatalogLoader::publish(const Game* game, unsigned int requestGeneration, bool done) {
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (requestGeneration != generation) {
+            return;
+        }
+        // One wake per batch: the UI drains everything queued up to that point.
+        notify = rows.empty() || done;
+        if (game) {
+            rows.add(*game);
+        }
+        if (done) {
+            busy = false;
+        }
+    }
+    if (notify && wake) {
+        wake();
+    }
+}
+
+void CatalogLoader::fetchPage(const Request& page, unsigned int requestGeneration) {
+    GameListParser parser([this, requestGeneration](const Game& game) {
+        publish(&game, requestGeneration, false);
+    });
+    // Returning false from the chunk callback aborts the transfer.
+    HttpCache::instance().fetch(page.url, [this, &parser, requestGeneration](const char* data, size_t size) {
+        return requestGeneration == generation && parser.feed(data, size);
+    });
+    if (requestGeneration != generation) {
+        std::cout << "Catalog load cancelled: " << page.url << std::endl;
+        return;
+    }
+    parser.finish();
+    std::cout << "Number of games parsed: " << parser.rowCount() << std::endl;
+    publish(nullptr, requestGeneration, true);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (requestGeneration == generation) {
+        prefetchQueue.assign(page.prefetchUrls.begin(), page.prefetchUrls.end());
+    }
+}
+
+void CatalogLoader::prefetch(const std::string& url, unsigned int requestGeneration) {
+    // A new load takes priority; an abandoned prefetch is simply not cached.
+    HttpCache::instance().fetch(url, [this, requestGeneration](const char*, size_t) {
+        return requestGeneration == generation;
+    }, TransferLane::Bulk);
+}
+
+void CatalogLoader::run() {
+    while (true) {
+        Request page;
+        std::string prefetchUrl;
+        unsigned int requestGeneration;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || hasRequest || !prefetchQueue.empty(); });
+            if (stopping) {
+                return;
+            }
+            requestGeneration = generation;
+            if (hasRequest) {
+                page = request;
+                hasRequest = false;
+            } else {
+                prefetchUrl = prefetchQueue.front();
+                prefetchQueue.pop_front();
+            }
+        }
+
+        if (!page.url.empty()) {
+            fetchPage(page, requestGeneration);
+        } else {
+            prefetch(prefetchUrl, requestGeneration);
+        }
+    }
+}
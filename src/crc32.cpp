@@ -0,0 +1,110 @@
+#include "crc32.h"
+#include <cstring>
+#include <zlib.h>
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+namespace {
+
+struct SliceTables {
+    uint32_t table[8][256];
+
+    SliceTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int t = 1; t < 8; t++) {
+                table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const SliceTables& tables() {
+    static SliceTables instance;
+    return instance;
+}
+
+uint32_t updateSliceBy8(uint32_t crc, const unsigned char* p, size_t size) {
+    const SliceTables& t = tables();
+    while (size >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t.table[7][lo & 0xFF] ^ t.table[6][(lo >> 8) & 0xFF] ^ t.table[5][(lo >> 16) & 0xFF] ^ t.table[4][lo >> 24] ^
+              t.table[3][hi & 0xFF] ^ t.table[2][(hi >> 8) & 0xFF] ^ t.table[1][(hi >> 16) & 0xFF] ^ t.table[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ t.table[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(__aarch64__)
+__attribute__((target("+crc")))
+uint32_t updateArmv8(uint32_t crc, const unsigned char* p, size_t size) {
+    while (size > 0 && ((uintptr_t)p & 7)) {
+        crc = __crc32b(crc, *p++);
+        size--;
+    }
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc = __crc32d(crc, word);
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = __crc32b(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+typedef uint32_t (*UpdateFunction)(uint32_t, const unsigned char*, size_t);
+
+bool hasCrcInstructions() {
+#if defined(__aarch64__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+
+UpdateFunction selectUpdate() {
+#if defined(__aarch64__)
+    if (hasCrcInstructions()) {
+        return updateArmv8;
+    }
+#endif
+    return updateSliceBy8;
+}
+
+} // namespace
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t size) {
+    static const UpdateFunction update = selectUpdate();
+    return ~update(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+uint32_t crc32Combine(uint32_t first, uint32_t second, long long secondLength) {
+    return crc32_combine(first, second, (z_off_t)secondLength);
+}
+
+const char* crc32Implementation() {
+    return hasCrcInstructions() ? "armv8-crc" : "slice-by-8";
+}
@@ -0,0 +1,41 @@
+#include "curl_api.h"
+#include <iostream>
+#include <dlfcn.h>
+
+bool CurlApi::load() {
+    handle = dlopen("/usr/lib/libcurl.so.4", RTLD_LAZY);
+    if (!handle) {
+        std::cerr << "Failed to load libcurl: " << dlerror() << std::endl;
+        return false;
+    }
+
+    easy_init = (curl_easy_init_t)dlsym(handle, "curl_easy_init");
+    easy_cleanup = (curl_easy_cleanup_t)dlsym(handle, "curl_easy_cleanup");
+    easy_setopt = (curl_easy_setopt_t)dlsym(handle, "curl_easy_setopt");
+    easy_perform = (curl_easy_perform_t)dlsym(handle, "curl_easy_perform");
+    easy_getinfo = (curl_easy_getinfo_t)dlsym(handle, "curl_easy_getinfo");
+    easy_strerror = (curl_easy_strerror_t)dlsym(handle, "curl_easy_strerror");
+    slist_append = (curl_slist_append_t)dlsym(handle, "curl_slist_append");
+    slist_free_all = (curl_slist_free_all_t)dlsym(handle, "curl_slist_free_all");
+    global_init = (curl_global_init_t)dlsym(handle, "curl_global_init");
+    easy_reset = (curl_easy_reset_t)dlsym(handle, "curl_easy_reset");
+    share_init = (curl_share_init_t)dlsym(handle, "curl_share_init");
+    share_setopt = (curl_share_setopt_t)dlsym(handle, "curl_share_setopt");
+    share_cleanup = (curl_share_cleanup_t)dlsym(handle, "curl_share_cleanup");
+
+    if (!easy_init || !easy_cleanup || !easy_setopt || !easy_perform || !easy_getinfo ||
+        !easy_strerror || !slist_append || !slist_free_all || !global_init || !easy_reset ||
+        !share_init || !share_setopt || !share_cleanup) {
+        std::cerr << "Failed to resolve libcurl functions." << std::endl;
+        unload();
+        return false;
+    }
+    return true;
+}
+
+void CurlApi::unload() {
+    if (handle) {
+        dlclose(handle);
+    }
+    *this = CurlApi();
+}
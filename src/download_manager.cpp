@@ -2,9 +2,27 @@
 #include "utils.h"
 #include <iostream>
 
-DownloadManager::DownloadManager() : downloadProgress(0), isDownloading(false), stopThread(false) {
-    std::cout << "DownloadManager initialized" << std::endl;
-    queueThread = std::thread(&DownloadManager::processDownloadQueue, this);
+const char* downloadStateName(DownloadState state) {
+    switch (state) {
+        case DownloadState::Queued: return "Queued";
+        case DownloadState::Resolving: return "Resolving";
+        case DownloadState::Downloading: return "Downloading";
+        case DownloadState::Extracting: return "Extracting";
+        case DownloadState::Done: return "Done";
+        case DownloadState::Failed: return "Failed";
+    }
+    return "";
+}
+
+DownloadManager::DownloadManager(ExtractionQueue* extractionQueue, int workerCount)
+    : extractionQueue(extractionQueue), active(0), stopThread(false), changes(0) {
+    if (workerCount < 1) {
+        workerCount = 1;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&DownloadManager::worker, this);
+    }
+    std::cout << "DownloadManager initialized with " << workerCount << " workers" << std::endl;
 }
 
 DownloadManager::~DownloadManager() {
@@ -12,82 +30,149 @@ DownloadManager::~DownloadManager() {
         std::lock_guard<std::mutex> lock(queueMutex);
         stopThread = true;
     }
-    queueCV.notify_one();
-    if (queueThread.joinable()) {
-        queueThread.join();
+    queueCV.notify_all();
+    // Running transfers see stopThread in their progress callback and abort,
+    // leaving their .part files to resume from next time.
+    for (auto& thread : workers) {
+        thread.join();
     }
     std::cout << "DownloadManager destroyed" << std::endl;
 }
 
-void DownloadManager::queueDownload(const std::string& console, const std::string& url, const std::string& gameTitle) {
+int DownloadManager::queueDownload(const std::string& console, const std::string& url, const std::string& gameTitle) {
+    int id;
     {
         std::lock_guard<std::mutex> lock(queueMutex);
         std::cout << "Queueing download: " << gameTitle << " from " << url << std::endl;
-        downloadQueue.push({console, url});
-        queuedGameTitles.push_back(gameTitle);
+        id = records.size();
+        Record record;
+        record.item.id = id;
+        record.item.console = console;
+        record.item.url = url;
+        record.item.title = gameTitle;
+        records.push_back(record);
+        pending.push_back(id);
     }
+    changes++;
     queueCV.notify_one();
+    return id;
+}
+
+std::vector<DownloadItem> DownloadManager::snapshot() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    std::vector<DownloadItem> items;
+    items.reserve(records.size());
+    for (const auto& record : records) {
+        items.push_back(record.item);
+    }
+    return items;
 }
 
-void DownloadManager::start() {
-    queueThread.detach();
+bool DownloadManager::busy() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return active > 0 || !pending.empty();
+}
+
+unsigned int DownloadManager::version() const {
+    return changes;
+}
+
+void DownloadManager::setState(int id, DownloadState state) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        Record& record = records[id];
+        record.item.state = state;
+        if (state == DownloadState::Downloading) {
+            record.sampleTime = std::chrono::steady_clock::now();
+            record.sampleBytes = record.item.bytesDone;
+        } else {
+            record.item.bytesPerSecond = 0.0;
+        }
+    }
+    changes++;
 }
 
-void DownloadManager::downloadGameThread(const std::string& console, const std::string& url, const std::string& gameTitle) {
+bool DownloadManager::updateProgress(int id, long long done, long long total) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    Record& record = records[id];
+    if (record.item.state != DownloadState::Downloading) {
+        record.item.state = DownloadState::Downloading;
+        record.sampleTime = std::chrono::steady_clock::now();
+        record.sampleBytes = done;
+        changes++;
+    }
+    if (done != record.item.bytesDone || total != record.item.bytesTotal) {
+        record.item.bytesDone = done;
+        record.item.bytesTotal = total;
+        changes++;
+    }
+
+    // Speed is smoothed over half-second samples so the readout does not flicker.
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - record.sampleTime).count();
+    if (elapsed >= 0.5) {
+        double rate = (done - record.sampleBytes) / elapsed;
+        record.item.bytesPerSecond = record.item.bytesPerSecond > 0 ? record.item.bytesPerSecond * 0.7 + rate * 0.3 : rate;
+        record.sampleTime = now;
+        record.sampleBytes = done;
+    }
+    return !stopThread;
+}
+
+void DownloadManager::process(int id) {
+    std::string console, url, gameTitle;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        console = records[id].item.console;
+        url = records[id].item.url;
+        gameTitle = records[id].item.title;
+    }
     std::cout << "Starting download: " << gameTitle << std::endl;
     std::cout << "Console: " << console << ", URL: " << url << std::endl;
-    isDownloading = true;
-    downloadProgress = 0;
+    setState(id, DownloadState::Resolving);
 
-    std::string htmlContent = getHtml(url);
+    ResponseBuffer htmlContent = getHtml(url);
     if (htmlContent.empty()) {
         std::cerr << "Failed to fetch HTML content from URL: " << url << std::endl;
-        isDownloading = false;
+        setState(id, DownloadState::Failed);
         return;
     }
 
-    int res = downloadGame(console, htmlContent);
+    int res = downloadGame(console, htmlContent, [this, id](long long done, long long total) {
+        return updateProgress(id, done, total);
+    }, [this, id] {
+        setState(id, DownloadState::Extracting);
+    }, extractionQueue);
 
     if (res == 0) {
         std::cout << "Game downloaded successfully: " << gameTitle << std::endl;
+        setState(id, DownloadState::Done);
     } else {
         std::cerr << "Failed to download game: " << gameTitle << std::endl;
+        setState(id, DownloadState::Failed);
     }
-
-    isDownloading = false;
-    queueCV.notify_one();
 }
 
-void DownloadManager::processDownloadQueue() {
-    std::cout << "Processing download queue" << std::endl;
+void DownloadManager::worker() {
     while (true) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        queueCV.wait(lock, [this] { return !downloadQueue.empty() || stopThread; });
-
-        if (stopThread && downloadQueue.empty()) {
-            break;
+        int id;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCV.wait(lock, [this] { return !pending.empty() || stopThread; });
+            if (stopThread) {
+                break;
+            }
+            id = pending.front();
+            pending.pop_front();
+            active++;
         }
 
-        if (!downloadQueue.empty()) {
-            auto [console, url] = downloadQueue.front();
-            downloadQueue.pop();
-            std::string gameTitle = queuedGameTitles.front();
-            queuedGameTitles.erase(queuedGameTitles.begin());
-            lock.unlock();
+        process(id);
 
-            std::cout << "Dequeued download: " << gameTitle << " from " << url << std::endl;
-            downloadGameThread(console, url, gameTitle);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            active--;
         }
+        changes++;
     }
-    std::cout << "Download queue processing stopped" << std::endl;
 }
-
-std::string DownloadManager::getFirstQueuedGameTitle() {
-    std::lock_guard<std::mutex> lock(queueMutex);
-    return !queuedGameTitles.empty() ? queuedGameTitles[0] : "";
-}
-
-std::vector<std::string> DownloadManager::getQueuedGameTitles() {
-    std::lock_guard<std::mutex> lock(queueMutex);
-    return queuedGameTitles;
-}
\ No newline at end of file
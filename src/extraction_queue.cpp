@@ -0,0 +1,290 @@
+#include "extraction_queue.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+static bool isArchive(const std::string& name) {
+    const char* extensions[] = {".7z", ".zip"};
+    for (const char* extension : extensions) {
+        size_t length = strlen(extension);
+        if (name.size() > length && strcasecmp(name.c_str() + name.size() - length, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ExtractionQueue::ExtractionQueue(const std::string& manifestPath, int workerCount)
+    : manifestPath(manifestPath), active(0), stopping(false), changes(0) {
+    loadManifest();
+    if (workerCount < 1) {
+        workerCount = std::thread::hardware_concurrency();
+    }
+    if (workerCount < 1) {
+        workerCount = 1;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&ExtractionQueue::worker, this);
+    }
+}
+
+ExtractionQueue::~ExtractionQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending.clear();
+        // Interrupted archives are not in the manifest and get redone next time.
+        for (const auto& child : children) {
+            kill(child.second, SIGTERM);
+        }
+    }
+    cv.notify_all();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+void ExtractionQueue::loadManifest() {
+    std::ifstream in(manifestPath);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Stamp stamp;
+        std::string path;
+        if (fields >> stamp.size >> stamp.mtime && std::getline(fields >> std::ws, path)) {
+            manifest[path] = stamp;
+        }
+    }
+}
+
+void ExtractionQueue::saveManifest() {
+    // Written whole and renamed into place, like the other sidecar files.
+    std::string tmpPath = manifestPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        for (const auto& entry : manifest) {
+            out << entry.second.size << " " << entry.second.mtime << " " << entry.first << "\n";
+        }
+    }
+    rename(tmpPath.c_str(), manifestPath.c_str());
+}
+
+bool ExtractionQueue::stampOf(const std::string& archive, Stamp& stamp) {
+    struct stat st;
+    if (stat(archive.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp = {(long long)st.st_size, (long long)st.st_mtime};
+    return true;
+}
+
+bool ExtractionQueue::extracted(const std::string& archive, Stamp& stamp) {
+    if (!stampOf(archive, stamp)) {
+        return false;
+    }
+    auto it = manifest.find(archive);
+    return it != manifest.end() && it->second.size == stamp.size && it->second.mtime == stamp.mtime;
+}
+
+int ExtractionQueue::scan(const std::string& romPath) {
+    DIR* dir = opendir(romPath.c_str());
+    if (!dir) {
+        std::cerr << "Failed to open " << romPath << ": " << strerror(errno) << std::endl;
+        return 0;
+    }
+    std::vector<std::string> archives;
+    while (struct dirent* entry = readdir(dir)) {
+        if (isArchive(entry->d_name)) {
+            archives.push_back(romPath + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    int queued = 0;
+    for (const auto& archive : archives) {
+        queued += enqueue(archive, romPath) ? 1 : 0;
+    }
+    std::cout << "Queued " << queued << " of " << archives.size() << " archives in " << romPath << std::endl;
+    return queued;
+}
+
+bool ExtractionQueue::enqueue(const std::string& archive, const std::string& outputDir, bool removeArchive) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stamp stamp;
+        if (extracted(archive, stamp)) {
+            return false;
+        }
+        for (int id : pending) {
+            if (jobs[id].archive == archive) {
+                return false;
+            }
+        }
+        for (const auto& job : jobs) {
+            if (job.archive == archive && job.state == ExtractState::Running) {
+                return false;
+            }
+        }
+        ExtractJob job;
+        job.id = jobs.size();
+        job.archive = archive;
+        job.outputDir = outputDir;
+        job.removeArchive = removeArchive;
+        jobs.push_back(job);
+        pending.push_back(job.id);
+    }
+    changes++;
+    cv.notify_one();
+    return true;
+}
+
+std::vector<ExtractJob> ExtractionQueue::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs;
+}
+
+bool ExtractionQueue::busy() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active > 0 || !pending.empty();
+}
+
+unsigned int ExtractionQueue::version() const {
+    return changes;
+}
+
+void ExtractionQueue::setPercent(int id, int percent) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs[id].percent == percent) {
+            return;
+        }
+        jobs[id].percent = percent;
+    }
+    changes++;
+}
+
+bool ExtractionQueue::run(int id) {
+    std::string archive, outputDir;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        archive = jobs[id].archive;
+        outputDir = jobs[id].outputDir;
+    }
+
+    // 7zz is run directly rather than through the shell, so its pid can be
+    // signalled on shutdown. -bsp1 sends the percentage to stdout and
+    // everything else is silenced.
+    std::string outputFlag = "-o" + outputDir;
+    const char* argv[] = {"7zz", "x", archive.c_str(), outputFlag.c_str(), "-y", "-bsp1", "-bso0", "-bse0", nullptr};
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execv("/mnt/SDCARD/System/bin/7zz", (char* const*)argv);
+        _exit(127);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        std::cerr << "Failed to start 7zz for " << archive << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        children[id] = pid;
+    }
+
+    // Progress arrives as "NN%" rewritten in place with backspaces.
+    char buffer[256];
+    int number = -1;
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            char c = buffer[i];
+            if (c >= '0' && c <= '9') {
+                number = (number < 0 ? 0 : number * 10) + (c - '0');
+            } else {
+                if (c == '%' && number >= 0 && number <= 100) {
+                    setPercent(id, number);
+                }
+                number = -1;
+            }
+        }
+    }
+
+    close(fds[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        children.erase(id);
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "Failed to extract " << archive << " (status " << status << ")" << std::endl;
+        return false;
+    }
+    std::cout << "Extracted " << archive << std::endl;
+    return true;
+}
+
+void ExtractionQueue::worker() {
+    while (true) {
+        int id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !pending.empty() || stopping; });
+            if (stopping) {
+                break;
+            }
+            id = pending.front();
+            pending.pop_front();
+            jobs[id].state = ExtractState::Running;
+            active++;
+        }
+        changes++;
+
+        bool ok = run(id);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs[id].state = ok ? ExtractState::Done : ExtractState::Failed;
+            if (ok && jobs[id].removeArchive) {
+                jobs[id].percent = 100;
+                unlink(jobs[id].archive.c_str());
+            } else if (ok) {
+                jobs[id].percent = 100;
+                // An archive that vanished during extraction is not recorded;
+                // it will be picked up again if it comes back.
+                Stamp stamp;
+                if (stampOf(jobs[id].archive, stamp)) {
+                    manifest[jobs[id].archive] = stamp;
+                    saveManifest();
+                }
+            }
+            active--;
+        }
+        changes++;
+    }
+}
@@ -0,0 +1,88 @@
+#include "frame_pacer.h"
+#include <sys/resource.h>
+#include <iostream>
+#include "config.h"
+
+FramePacer::FramePacer()
+    : dirty(true), hasDeadline(false), deadline(0), frameStart(0), frameMs(0), windowStart(SDL_GetTicks()), cpuStart(threadCpuSeconds()),
+      frames(0), wakeups(0), totalFrames(0), totalWakeups(0) {}
+
+double FramePacer::threadCpuSeconds() {
+    // Only the render thread: download and parse workers are accounted separately.
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+void FramePacer::invalidate() {
+    dirty = true;
+}
+
+void FramePacer::wakeAt(Uint32 ticks) {
+    if (!hasDeadline || SDL_TICKS_PASSED(deadline, ticks)) {
+        deadline = ticks;
+        hasDeadline = true;
+    }
+}
+
+bool FramePacer::waitEvent(SDL_Event& event) {
+    // Pending redraws only need a poll; otherwise sleep until the next wake.
+    int timeout = 0;
+    if (!dirty) {
+        Uint32 now = SDL_GetTicks();
+        Uint32 reportAt = windowStart + FRAME_STATS_INTERVAL_MS;
+        Uint32 wake = hasDeadline && SDL_TICKS_PASSED(reportAt, deadline) ? deadline : reportAt;
+        timeout = SDL_TICKS_PASSED(now, wake) ? 0 : (int)(wake - now);
+    }
+    hasDeadline = false;
+    wakeups++;
+    bool gotEvent = timeout > 0 ? SDL_WaitEventTimeout(&event, timeout) == 1 : SDL_PollEvent(&event) == 1;
+    report();
+    return gotEvent;
+}
+
+bool FramePacer::render() {
+    if (!dirty) {
+        return false;
+    }
+    dirty = false;
+    frameStart = SDL_GetPerformanceCounter();
+    return true;
+}
+
+void FramePacer::drawn() {
+    double ms = (SDL_GetPerformanceCounter() - frameStart) * 1000.0 / SDL_GetPerformanceFrequency();
+    frameMs = frameMs > 0 ? frameMs * 0.9 + ms * 0.1 : ms;
+}
+
+void FramePacer::presented() {
+    frames++;
+}
+
+double FramePacer::frameTime() const {
+    return frameMs;
+}
+
+void FramePacer::report(bool force) {
+    Uint32 now = SDL_GetTicks();
+    Uint32 elapsed = now - windowStart;
+    if (!force && elapsed < FRAME_STATS_INTERVAL_MS) {
+        return;
+    }
+    double cpu = threadCpuSeconds();
+    totalFrames += frames;
+    totalWakeups += wakeups;
+    if (elapsed > 0) {
+        std::cout << "Render loop: " << frames << " frames, " << wakeups << " wakeups in " << elapsed / 1000.0 << "s ("
+                  << frames * 1000.0 / elapsed << " fps, " << (cpu - cpuStart) * 100000.0 / elapsed << "% CPU)" << std::endl;
+    }
+    if (force) {
+        std::cout << "Render loop total: " << totalFrames << " frames, " << totalWakeups << " wakeups" << std::endl;
+    }
+    windowStart = now;
+    cpuStart = cpu;
+    frames = 0;
+    wakeups = 0;
+}
@@ -0,0 +1,161 @@
+#include "game_list.h"
+#include <algorithm>
+#include <iostream>
+
+size_t GameList::size() const {
+    return titles.size();
+}
+
+bool GameList::empty() const {
+    return titles.empty();
+}
+
+void GameList::clear() {
+    pool.clear();
+    titles.clear();
+    urls.clear();
+    regions.clear();
+    versions.clear();
+    languageSets.clear();
+    ratings.clear();
+    values.clear();
+    valueSlots.clear();
+}
+
+void GameList::reserve(size_t games, size_t textBytes) {
+    pool.reserve(textBytes);
+    titles.reserve(games);
+    urls.reserve(games);
+    regions.reserve(games);
+    versions.reserve(games);
+    languageSets.reserve(games);
+    ratings.reserve(games);
+}
+
+GameList::Span GameList::store(std::string_view text) {
+    Span span = {(uint32_t)pool.size(), (uint32_t)text.size()};
+    pool.append(text.data(), text.size());
+    return span;
+}
+
+std::string_view GameList::view(Span span) const {
+    return std::string_view(pool.data() + span.offset, span.length);
+}
+
+static size_t hashValue(std::string_view text) {
+    // FNV-1a; the values are short and few.
+    size_t hash = 2166136261u;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+void GameList::growValueSlots() {
+    valueSlots.assign(std::max<size_t>(16, valueSlots.size() * 2), 0);
+    size_t mask = valueSlots.size() - 1;
+    for (size_t id = 1; id < values.size(); id++) {
+        size_t slot = hashValue(view(values[id])) & mask;
+        while (valueSlots[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        valueSlots[slot] = id;
+    }
+}
+
+uint16_t GameList::intern(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    if (values.empty()) {
+        values.push_back({0, 0});
+    }
+    // Kept at most half full, so probes stay short.
+    if ((values.size() + 1) * 2 > valueSlots.size()) {
+        growValueSlots();
+    }
+    size_t mask = valueSlots.size() - 1;
+    size_t slot = hashValue(text) & mask;
+    for (; valueSlots[slot]; slot = (slot + 1) & mask) {
+        if (view(values[valueSlots[slot]]) == text) {
+            return valueSlots[slot];
+        }
+    }
+    if (values.size() > UINT16_MAX) {
+        // Not seen on any real page; the value is dropped rather than aliased.
+        std::cerr << "GameList: too many distinct values, dropping \"" << text << "\"" << std::endl;
+        return 0;
+    }
+    uint16_t id = values.size();
+    values.push_back(store(text));
+    valueSlots[slot] = id;
+    return id;
+}
+
+void GameList::add(std::string_view title, std::string_view region, std::string_view version, std::string_view languages,
+                   std::string_view rating, std::string_view url) {
+    titles.push_back(store(title));
+    urls.push_back(store(url));
+    regions.push_back(intern(region));
+    versions.push_back(intern(version));
+    languageSets.push_back(intern(languages));
+    ratings.push_back(intern(rating));
+}
+
+void GameList::add(const Game& game) {
+    add(game.title, game.region, game.version, game.languages, game.rating, game.url);
+}
+
+void GameList::append(const GameList& other) {
+    if (empty()) {
+        *this = other;
+        return;
+    }
+    reserve(size() + other.size(), pool.size() + other.pool.size());
+    for (size_t i = 0; i < other.size(); i++) {
+        add(other.title(i), other.region(i), other.version(i), other.languages(i), other.rating(i), other.url(i));
+    }
+}
+
+std::string_view GameList::title(size_t index) const {
+    return view(titles[index]);
+}
+
+std::string_view GameList::region(size_t index) const {
+    return regions[index] ? view(values[regions[index]]) : std::string_view();
+}
+
+std::string_view GameList::version(size_t index) const {
+    return versions[index] ? view(values[versions[index]]) : std::string_view();
+}
+
+std::string_view GameList::languages(size_t index) const {
+    return languageSets[index] ? view(values[languageSets[index]]) : std::string_view();
+}
+
+std::string_view GameList::rating(size_t index) const {
+    return ratings[index] ? view(values[ratings[index]]) : std::string_view();
+}
+
+std::string_view GameList::url(size_t index) const {
+    return view(urls[index]);
+}
+
+Game GameList::game(size_t index) const {
+    Game game;
+    game.title = title(index);
+    game.region = region(index);
+    game.version = version(index);
+    game.languages = languages(index);
+    game.rating = rating(index);
+    game.url = url(index);
+    return game;
+}
+
+size_t GameList::bytesUsed() const {
+    size_t bytes = pool.capacity();
+    bytes += (titles.capacity() + urls.capacity() + values.capacity()) * sizeof(Span);
+    bytes += (regions.capacity() + versions.capacity() + languageSets.capacity() + ratings.capacity()) * sizeof(uint16_t);
+    bytes += valueSlots.capacity() * sizeof(uint16_t);
+    return bytes;
+}
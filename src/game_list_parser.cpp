@@ -0,0 +1,172 @@
+#include "game_list_parser.h"
+#include <iostream>
+#include <cstring>
+#include <strings.h>
+
+// Column layout of a vault letter page, matching parseGamesHTML().
+enum { CELL_TITLE, CELL_REGION, CELL_VERSION, CELL_LANGUAGES, CELL_RATING };
+
+static bool nameIs(const xmlChar* name, const char* expected) {
+    return name && strcasecmp(reinterpret_cast<const char*>(name), expected) == 0;
+}
+
+static const char* attribute(const xmlChar** attrs, const char* name) {
+    for (int i = 0; attrs && attrs[i]; i += 2) {
+        if (nameIs(attrs[i], name)) {
+            return attrs[i + 1] ? reinterpret_cast<const char*>(attrs[i + 1]) : "";
+        }
+    }
+    return nullptr;
+}
+
+GameListParser::GameListParser(std::function<void(const Game&)> onGame)
+    : onGame(std::move(onGame)), ctxt(nullptr), rows(0), inRow(false), rowHasLink(false), cell(-1), cellDepth(0), inLink(false) {
+    htmlSAXHandler sax;
+    memset(&sax, 0, sizeof(sax));
+    sax.startElement = startElement;
+    sax.endElement = endElement;
+    sax.characters = characters;
+    sax.ignorableWhitespace = characters;
+
+    ctxt = htmlCreatePushParserCtxt(&sax, this, nullptr, 0, nullptr, XML_CHAR_ENCODING_UTF8);
+    if (!ctxt) {
+        std::cerr << "Error: unable to create HTML push parser\n";
+        return;
+    }
+    htmlCtxtUseOptions(ctxt, HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+}
+
+GameListParser::~GameListParser() {
+    if (ctxt) {
+        htmlFreeParserCtxt(ctxt);
+    }
+}
+
+bool GameListParser::feed(const char* data, size_t size) {
+    if (!ctxt) {
+        return false;
+    }
+    // HTML errors are recoverable, so the return code is only informative.
+    htmlParseChunk(ctxt, data, size, 0);
+    return true;
+}
+
+bool GameListParser::finish() {
+    if (!ctxt) {
+        return false;
+    }
+    htmlParseChunk(ctxt, nullptr, 0, 1);
+    return true;
+}
+
+size_t GameListParser::rowCount() const {
+    return rows;
+}
+
+void GameListParser::beginRow() {
+    inRow = true;
+    rowHasLink = false;
+    cell = -1;
+    cellDepth = 0;
+    inLink = false;
+    // Cleared rather than replaced so the strings keep their capacity.
+    game.title.clear();
+    game.region.clear();
+    game.version.clear();
+    game.languages.clear();
+    game.rating.clear();
+    game.url.clear();
+}
+
+void GameListParser::endRow() {
+    if (inRow && rowHasLink) {
+        rows++;
+        onGame(game);
+    }
+    inRow = false;
+    cell = -1;
+}
+
+void GameListParser::startElement(void* ctx, const xmlChar* name, const xmlChar** attrs) {
+    GameListParser* self = static_cast<GameListParser*>(ctx);
+
+    if (nameIs(name, "tr")) {
+        self->beginRow();
+        return;
+    }
+    if (!self->inRow) {
+        return;
+    }
+    if (nameIs(name, "td") && self->cellDepth == 0) {
+        self->cell++;
+        self->cellDepth = 1;
+        return;
+    }
+    if (self->cellDepth == 0) {
+        return;
+    }
+
+    self->cellDepth++;
+    // Only direct children of the cell count, as in the td/a XPath.
+    bool directChild = self->cellDepth == 2;
+    if (nameIs(name, "a") && directChild) {
+        self->rowHasLink = true;
+        self->inLink = true;
+        if (self->cell == CELL_TITLE) {
+            const char* href = attribute(attrs, "href");
+            if (href) {
+                self->game.url = href;
+            }
+        }
+    } else if (nameIs(name, "img") && directChild && self->cell == CELL_REGION) {
+        const char* title = attribute(attrs, "title");
+        if (title && self->game.region.empty()) {
+            self->game.region = title;
+        }
+    }
+}
+
+void GameListParser::endElement(void* ctx, const xmlChar* name) {
+    GameListParser* self = static_cast<GameListParser*>(ctx);
+    if (!self->inRow) {
+        return;
+    }
+    if (nameIs(name, "tr")) {
+        self->endRow();
+        return;
+    }
+    if (self->cellDepth == 0) {
+        return;
+    }
+    if (nameIs(name, "a")) {
+        self->inLink = false;
+    }
+    self->cellDepth--;
+}
+
+void GameListParser::characters(void* ctx, const xmlChar* text, int length) {
+    GameListParser* self = static_cast<GameListParser*>(ctx);
+    if (!self->inRow || self->cellDepth == 0) {
+        return;
+    }
+
+    const char* chars = reinterpret_cast<const char*>(text);
+    switch (self->cell) {
+    case CELL_TITLE:
+        if (self->inLink) {
+            self->game.title.append(chars, length);
+        }
+        break;
+    case CELL_VERSION:
+        self->game.version.append(chars, length);
+        break;
+    case CELL_LANGUAGES:
+        self->game.languages.append(chars, length);
+        break;
+    case CELL_RATING:
+        if (self->inLink) {
+            self->game.rating.append(chars, length);
+        }
+        break;
+    }
+}
@@ -0,0 +1,160 @@
+#include "glyph_atlas.h"
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+GlyphAtlas::GlyphAtlas() : renderer(nullptr), font(nullptr), texture(nullptr), lineHeight(0) {}
+
+GlyphAtlas::~GlyphAtlas() {
+    destroy();
+}
+
+void GlyphAtlas::destroy() {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+    widthCache.clear();
+}
+
+bool GlyphAtlas::ready() const {
+    return texture != nullptr;
+}
+
+int GlyphAtlas::height() const {
+    return lineHeight;
+}
+
+bool GlyphAtlas::build(SDL_Renderer* targetRenderer, TTF_Font* targetFont) {
+    destroy();
+    renderer = targetRenderer;
+    font = targetFont;
+    lineHeight = TTF_FontHeight(font);
+
+    // Render every glyph first, then shelf-pack them into one page.
+    SDL_Color white = {255, 255, 255, 255};
+    std::vector<SDL_Surface*> surfaces(GLYPH_COUNT, nullptr);
+    int x = 0, y = 0, shelfHeight = 0;
+    for (int c = FIRST_GLYPH; c < GLYPH_COUNT; c++) {
+        if ((c >= 127 && c < 160) || !TTF_GlyphIsProvided(font, c)) {
+            continue;
+        }
+        int minx, maxx, miny, maxy, advance;
+        if (TTF_GlyphMetrics(font, c, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+            continue;
+        }
+        SDL_Surface* surface = TTF_RenderGlyph_Blended(font, c, white);
+        if (!surface) {
+            continue;
+        }
+        if (x + surface->w > PAGE_WIDTH) {
+            x = 0;
+            y += shelfHeight + 1;
+            shelfHeight = 0;
+        }
+        surfaces[c] = surface;
+        glyphs[c].present = true;
+        glyphs[c].src = {x, y, surface->w, surface->h};
+        glyphs[c].advance = advance;
+        x += surface->w + 1;
+        shelfHeight = std::max(shelfHeight, surface->h);
+    }
+    int pageHeight = y + shelfHeight;
+
+    SDL_Surface* page = SDL_CreateRGBSurfaceWithFormat(0, PAGE_WIDTH, pageHeight > 0 ? pageHeight : 1, 32, SDL_PIXELFORMAT_RGBA32);
+    if (page) {
+        SDL_FillRect(page, nullptr, SDL_MapRGBA(page->format, 255, 255, 255, 0));
+    }
+    for (int c = 0; c < GLYPH_COUNT; c++) {
+        if (!surfaces[c]) {
+            continue;
+        }
+        if (page) {
+            // Copy coverage as-is instead of blending it onto the empty page.
+            SDL_SetSurfaceBlendMode(surfaces[c], SDL_BLENDMODE_NONE);
+            SDL_Rect dst = glyphs[c].src;
+            SDL_BlitSurface(surfaces[c], nullptr, page, &dst);
+        }
+        SDL_FreeSurface(surfaces[c]);
+    }
+    if (!page) {
+        std::cerr << "Failed to create glyph atlas surface: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    texture = SDL_CreateTextureFromSurface(renderer, page);
+    SDL_FreeSurface(page);
+    if (!texture) {
+        std::cerr << "Failed to create glyph atlas texture: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    std::cout << "Glyph atlas built: " << PAGE_WIDTH << "x" << pageHeight << std::endl;
+    return true;
+}
+
+Uint16 GlyphAtlas::nextCodepoint(const std::string& text, size_t& pos) const {
+    unsigned char c = text[pos++];
+    Uint16 codepoint = c;
+    if (c >= 0xC0 && c < 0xE0 && pos < text.size()) {
+        codepoint = ((c & 0x1F) << 6) | (text[pos++] & 0x3F);
+    } else if (c >= 0xE0) {
+        // Outside the atlas; skip the continuation bytes.
+        while (pos < text.size() && (text[pos] & 0xC0) == 0x80) {
+            pos++;
+        }
+        codepoint = '?';
+    }
+    if (codepoint >= GLYPH_COUNT || !glyphs[codepoint].present) {
+        codepoint = '?';
+    }
+    return codepoint;
+}
+
+int GlyphAtlas::kerning(Uint16 previous, Uint16 current) const {
+    return previous ? TTF_GetFontKerningSizeGlyphs(font, previous, current) : 0;
+}
+
+int GlyphAtlas::measure(const std::string& text) {
+    auto it = widthCache.find(text);
+    if (it != widthCache.end()) {
+        return it->second;
+    }
+
+    int width = 0;
+    Uint16 previous = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        Uint16 c = nextCodepoint(text, pos);
+        width += kerning(previous, c) + glyphs[c].advance;
+        previous = c;
+    }
+
+    if (widthCache.size() >= MAX_CACHED_WIDTHS) {
+        widthCache.clear();
+    }
+    widthCache.emplace(text, width);
+    return width;
+}
+
+void GlyphAtlas::draw(const std::string& text, int x, int y, SDL_Color color) {
+    if (!texture) {
+        return;
+    }
+    SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(texture, color.a);
+
+    // Consecutive copies from one texture are merged by SDL's render batching.
+    int penX = x;
+    Uint16 previous = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        Uint16 c = nextCodepoint(text, pos);
+        penX += kerning(previous, c);
+        const Glyph& glyph = glyphs[c];
+        if (glyph.present) {
+            SDL_Rect dst = {penX, y, glyph.src.w, glyph.src.h};
+            SDL_RenderCopy(renderer, texture, &glyph.src, &dst);
+        }
+        penX += glyph.advance;
+        previous = c;
+    }
+}
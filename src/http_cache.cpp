@@ -0,0 +1,245 @@
+#include "http_cache.h"
+#include "http_client.h"
+#include "config.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstdio>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unistd.h>
+
+HttpCache& HttpCache::instance() {
+    // The client is created first so it is destroyed after the cache has
+    // joined its revalidation thread.
+    HttpClient::instance();
+    static HttpCache cache(CACHE_DIR "/http");
+    return cache;
+}
+
+HttpCache::HttpCache(const std::string& directory) : directory(directory), stopping(false), tmpCounter(0) {
+    std::string path;
+    std::stringstream parts(directory);
+    std::string part;
+    while (std::getline(parts, part, '/')) {
+        path += part + "/";
+        mkdir(path.c_str(), 0755);
+    }
+}
+
+HttpCache::~HttpCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        staleUrls.clear();
+    }
+    staleCv.notify_all();
+    if (revalidator.joinable()) {
+        revalidator.join();
+    }
+}
+
+std::string HttpCache::pathFor(const std::string& url) const {
+    // FNV-1a keeps file names short and filesystem-safe.
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+    return directory + "/" + name;
+}
+
+bool HttpCache::readEntry(const std::string& url, Entry& entry) {
+    std::string base = pathFor(url);
+    std::ifstream meta(base + ".meta");
+    if (!meta) {
+        return false;
+    }
+
+    std::string line;
+    std::string cachedUrl;
+    while (std::getline(meta, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq);
+        if (key == "url") {
+            cachedUrl = line.substr(eq + 1);
+        } else if (key == "etag") {
+            entry.etag = line.substr(eq + 1);
+        } else if (key == "lastModified") {
+            entry.lastModified = line.substr(eq + 1);
+        }
+    }
+    return cachedUrl == url;
+}
+
+bool HttpCache::lookup(const std::string& url, ResponseBuffer& body) {
+    Entry entry;
+    return readEntry(url, entry) && body.readFile(pathFor(url) + ".body");
+}
+
+void HttpCache::store(const std::string& url, const std::string& etag, const std::string& lastModified, const ResponseBuffer& body) {
+    std::string base = pathFor(url);
+    // Revalidation and a fresh download can store the same URL at once, so
+    // each writer gets its own temporary files.
+    std::string suffix = "." + std::to_string(getpid()) + "." + std::to_string(tmpCounter++) + ".tmp";
+    std::string bodyTmp = base + ".body" + suffix;
+    std::string metaTmp = base + ".meta" + suffix;
+
+    // The body goes down first and the meta file last, so a torn write
+    // never leaves a meta file pointing at a partial body.
+    bool ok;
+    {
+        std::ofstream out(bodyTmp, std::ios::binary | std::ios::trunc);
+        for (size_t i = 0; out && i < body.segmentCount(); i++) {
+            out.write(body.segmentData(i), body.segmentSize(i));
+        }
+        out.close();
+        ok = !out.fail();
+    }
+    if (ok) {
+        std::ofstream out(metaTmp, std::ios::trunc);
+        out << "url=" << url << "\n";
+        out << "etag=" << etag << "\n";
+        out << "lastModified=" << lastModified << "\n";
+        out.close();
+        ok = !out.fail();
+    }
+    if (!ok) {
+        std::cerr << "Failed to write cache entry for " << url << std::endl;
+        unlink(bodyTmp.c_str());
+        unlink(metaTmp.c_str());
+        return;
+    }
+    // The two renames are paired under the lock so concurrent writers
+    // cannot leave one's body behind the other's meta.
+    std::lock_guard<std::mutex> lock(mutex);
+    rename(bodyTmp.c_str(), (base + ".body").c_str());
+    rename(metaTmp.c_str(), (base + ".meta").c_str());
+}
+
+// Hands a finished body to a chunk callback, segment by segment.
+static void feed(const ResponseBuffer& body, const ChunkCallback& onChunk) {
+    for (size_t i = 0; onChunk && i < body.segmentCount(); i++) {
+        if (!onChunk(body.segmentData(i), body.segmentSize(i))) {
+            return;
+        }
+    }
+}
+
+HttpCache::Result HttpCache::download(const std::string& url, const ChunkCallback& onChunk, TransferLane lane) {
+    HttpResponse response = HttpClient::instance().get(url, {}, lane, onChunk);
+    Result result = {response.error == 0 && response.status == 200, nullptr};
+    if (result.complete) {
+        store(url, response.etag, response.lastModified, response.body);
+    }
+    result.body = std::make_shared<const ResponseBuffer>(std::move(response.body));
+    return result;
+}
+
+void HttpCache::revalidate(const std::string& url) {
+    Entry entry;
+    if (!readEntry(url, entry)) {
+        return;
+    }
+
+    std::vector<std::string> headers;
+    if (!entry.etag.empty()) {
+        headers.push_back("If-None-Match: " + entry.etag);
+    }
+    if (!entry.lastModified.empty()) {
+        headers.push_back("If-Modified-Since: " + entry.lastModified);
+    }
+
+    // Shutdown aborts the transfer at its next chunk.
+    HttpResponse response = HttpClient::instance().get(url, headers, TransferLane::Bulk,
+                                                       [this](const char*, size_t) { return !stopping; });
+    if (response.error != 0 || stopping) {
+        return;
+    }
+    if (response.status == 304) {
+        std::cout << "Cache still fresh: " << url << std::endl;
+    } else if (response.status == 200) {
+        std::cout << "Cache updated: " << url << std::endl;
+        store(url, response.etag, response.lastModified, response.body);
+    }
+}
+
+// Revalidations run one at a time, in the order the pages were served.
+void HttpCache::revalidateLoop() {
+    while (true) {
+        std::string url;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            staleCv.wait(lock, [this] { return stopping || !staleUrls.empty(); });
+            if (stopping) {
+                return;
+            }
+            url = staleUrls.front();
+            staleUrls.pop_front();
+        }
+        revalidate(url);
+    }
+}
+
+ResponseBody HttpCache::fetch(const std::string& url, const ChunkCallback& onChunk, TransferLane lane) {
+    std::promise<Result> promise;
+    std::shared_future<Result> pending;
+    bool owner = false;
+    // Someone else is already fetching this URL; share their result. If
+    // they gave up part way, try once more on our own, and after that hand
+    // back the failure.
+    for (int attempt = 0; attempt < 2 && !owner; attempt++) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = inflight.find(url);
+            if (it != inflight.end()) {
+                pending = it->second;
+            } else {
+                pending = promise.get_future().share();
+                inflight[url] = pending;
+                owner = true;
+            }
+        }
+        if (!owner) {
+            const Result& shared = pending.get();
+            if (shared.complete) {
+                feed(*shared.body, onChunk);
+                return shared.body;
+            }
+            if (attempt == 1) {
+                return shared.body;
+            }
+        }
+    }
+
+    ResponseBuffer cachedBody;
+    bool cached = lookup(url, cachedBody);
+    Result result;
+    if (cached) {
+        result = {true, std::make_shared<const ResponseBuffer>(std::move(cachedBody))};
+        feed(*result.body, onChunk);
+    } else {
+        result = download(url, onChunk, lane);
+    }
+    // The entry goes before the result is published, so a waiter that
+    // retries never finds this finished request again.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inflight.erase(url);
+        if (cached && !stopping && revalidated.insert(url).second) {
+            staleUrls.push_back(url);
+            if (!revalidator.joinable()) {
+                revalidator = std::thread(&HttpCache::revalidateLoop, this);
+            }
+        }
+    }
+    staleCv.notify_one();
+    promise.set_value(result);
+    return result.body;
+}
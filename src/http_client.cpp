@@ -0,0 +1,198 @@
+#include "http_client.h"
+#include "transfer_stats.h"
+#include "segmented_download.h"
+#include <iostream>
+#include <cstdlib>
+
+HttpClient& HttpClient::instance() {
+    static HttpClient client;
+    return client;
+}
+
+HttpClient::HttpClient() : loaded(false), share(nullptr) {
+    if (!curl.load()) {
+        return;
+    }
+    loaded = true;
+    curl.global_init(CURL_GLOBAL_ALL);
+
+    share = curl.share_init();
+    if (share) {
+        curl.share_setopt(share, CURLSHOPT_LOCKFUNC, (curl_lock_function_t)lockShare);
+        curl.share_setopt(share, CURLSHOPT_UNLOCKFUNC, (curl_unlock_function_t)unlockShare);
+        curl.share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl.share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl.share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        // Connection sharing needs libcurl 7.57; older builds keep a per-handle cache.
+        if (curl.share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) != 0) {
+            std::cout << "libcurl cannot share connections, using per-handle caches" << std::endl;
+        }
+    }
+}
+
+HttpClient::~HttpClient() {
+    if (!loaded) {
+        return;
+    }
+    for (CURL* handle : idleHandles) {
+        curl.easy_cleanup(handle);
+    }
+    idleHandles.clear();
+    if (share) {
+        curl.share_cleanup(share);
+    }
+    curl.unload();
+}
+
+bool HttpClient::available() const {
+    return loaded;
+}
+
+CurlApi& HttpClient::api() {
+    return curl;
+}
+
+void HttpClient::lockShare(CURL*, int data, int, void* userptr) {
+    HttpClient* client = static_cast<HttpClient*>(userptr);
+    client->shareLocks[data % CURL_LOCK_DATA_LAST].lock();
+}
+
+void HttpClient::unlockShare(CURL*, int data, void* userptr) {
+    HttpClient* client = static_cast<HttpClient*>(userptr);
+    client->shareLocks[data % CURL_LOCK_DATA_LAST].unlock();
+}
+
+CURL* HttpClient::acquire() {
+    if (!loaded) {
+        return nullptr;
+    }
+
+    CURL* handle = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!idleHandles.empty()) {
+            handle = idleHandles.back();
+            idleHandles.pop_back();
+        }
+    }
+    if (!handle) {
+        handle = curl.easy_init();
+        if (!handle) {
+            std::cerr << "Failed to initialize curl" << std::endl;
+            return nullptr;
+        }
+    }
+
+    // easy_reset() on release clears options but keeps the handle's caches,
+    // so the common options are applied on every checkout.
+    if (share) {
+        curl.easy_setopt(handle, CURLOPT_SHARE, share);
+    }
+    curl.easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L); // Disable SSL verification
+    curl.easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L); // Disable host verification
+    curl.easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl.easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl.easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    return handle;
+}
+
+void HttpClient::release(CURL* handle) {
+    if (!handle) {
+        return;
+    }
+    curl.easy_reset(handle);
+    std::lock_guard<std::mutex> lock(poolMutex);
+    idleHandles.push_back(handle);
+}
+
+struct ChunkTarget {
+    const ChunkCallback* onChunk;
+    TransferLane lane;
+    HttpResponse* collect;
+};
+
+static size_t chunkCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    const ChunkTarget* target = static_cast<const ChunkTarget*>(userdata);
+    if (target->collect) {
+        // Headers are in by the first chunk, so the body can be sized once.
+        ResponseBuffer& body = target->collect->body;
+        if (body.empty() && target->collect->contentLength > 0) {
+            body.reserve(target->collect->contentLength);
+        }
+        body.append(ptr, size * nmemb);
+    }
+    if (*target->onChunk && !(*target->onChunk)(ptr, size * nmemb)) {
+        return 0;
+    }
+    TransferScheduler::instance().throttle(target->lane, size * nmemb);
+    return size * nmemb;
+}
+
+static size_t responseHeaderCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    HttpResponse* response = static_cast<HttpResponse*>(userdata);
+    std::string line(ptr, size * nmemb);
+    std::string value;
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        response->contentLength = -1;
+        response->etag.clear();
+        response->lastModified.clear();
+    } else if (parseHeaderLine(line, "Content-Length", value)) {
+        response->contentLength = std::atoll(value.c_str());
+    } else if (parseHeaderLine(line, "ETag", value)) {
+        response->etag = value;
+    } else if (parseHeaderLine(line, "Last-Modified", value)) {
+        response->lastModified = value;
+    }
+    return size * nmemb;
+}
+
+HttpResponse HttpClient::get(const std::string& url, const std::vector<std::string>& headers, TransferLane lane,
+                             const ChunkCallback& onChunk) {
+    return perform(url, onChunk, headers, lane, true);
+}
+
+HttpResponse HttpClient::stream(const std::string& url, const ChunkCallback& onChunk, const std::vector<std::string>& headers,
+                               TransferLane lane) {
+    return perform(url, onChunk, headers, lane, false);
+}
+
+HttpResponse HttpClient::perform(const std::string& url, const ChunkCallback& onChunk, const std::vector<std::string>& headers,
+                                 TransferLane lane, bool collect) {
+    HttpResponse response;
+    CURL* handle = acquire();
+    if (!handle) {
+        response.error = -1;
+        return response;
+    }
+
+    struct curl_slist* headerList = nullptr;
+    for (const auto& header : headers) {
+        headerList = curl.slist_append(headerList, header.c_str());
+    }
+
+    curl.easy_setopt(handle, CURLOPT_URL, url.c_str());
+    if (headerList) {
+        curl.easy_setopt(handle, CURLOPT_HTTPHEADER, headerList);
+    }
+    curl.easy_setopt(handle, CURLOPT_WRITEFUNCTION, chunkCallback);
+    ChunkTarget target = {&onChunk, lane, collect ? &response : nullptr};
+    curl.easy_setopt(handle, CURLOPT_WRITEDATA, &target);
+    curl.easy_setopt(handle, CURLOPT_HEADERFUNCTION, responseHeaderCallback);
+    curl.easy_setopt(handle, CURLOPT_HEADERDATA, &response);
+
+    TransferScheduler& scheduler = TransferScheduler::instance();
+    scheduler.begin(lane);
+    response.error = curl.easy_perform(handle);
+    scheduler.end(lane);
+    curl.easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response.status);
+    TransferStats::instance().record(curl, handle, url, response.error);
+    if (response.error != CURLE_OK && response.error != CURLE_WRITE_ERROR) {
+        std::cerr << "GET " << url << " failed: " << curl.easy_strerror(response.error) << std::endl;
+    }
+
+    release(handle);
+    if (headerList) {
+        curl.slist_free_all(headerList);
+    }
+    return response;
+}
@@ -0,0 +1,102 @@
+#include "list_view.h"
+#include "theme.h"
+#include <algorithm>
+
+const char* const ListView::MARQUEE_GAP = "      ";
+
+ListView::ListView(Renderer& renderer) : renderer(renderer), marqueeStep(0), marqueeScrolls(false) {}
+
+ListView::~ListView() {
+    clear();
+}
+
+void ListView::release(Row& row) {
+    if (row.texture) {
+        SDL_DestroyTexture(row.texture);
+    }
+    row = Row();
+}
+
+void ListView::clear() {
+    for (Row& row : rows) {
+        release(row);
+    }
+    release(marquee);
+}
+
+// Whether the selected label is too wide and needs marquee ticks.
+bool ListView::scrolling() const {
+    return marqueeScrolls;
+}
+
+// Rows are shortened to MAX_LABEL characters; the marquee texture holds the
+// whole label followed by the gap that separates it from its next lap.
+void ListView::build(Row& row, std::string_view text, bool full) {
+    release(row);
+    row.text = text;
+    std::string shown(text);
+    if (full) {
+        shown += MARQUEE_GAP;
+    } else if (shown.size() > MAX_LABEL) {
+        shown = shown.substr(0, MAX_LABEL - 3) + "...";
+    }
+    row.texture = renderer.createTextTexture(shown, row.w, row.h);
+}
+
+void ListView::drawMarquee(int x, int y, std::string_view text, int scrollOffset, SDL_Color color) {
+    if (!marquee.texture || marquee.text != text) {
+        build(marquee, text, true);
+        marqueeStep = std::max(1, renderer.measureText("n"));
+        marqueeScrolls = renderer.measureText(marquee.text) > MARQUEE_WIDTH;
+    }
+    if (!marquee.texture) {
+        return;
+    }
+    if (!marqueeScrolls) {
+        // Fits as it is: nothing to scroll.
+        SDL_Rect dst = {x, y, marquee.w, marquee.h};
+        renderer.drawTexture(marquee.texture, nullptr, dst, color);
+        return;
+    }
+    // One step per marquee tick, wrapping around to the start of the label.
+    int start = (int)((long long)scrollOffset * marqueeStep % marquee.w);
+    int first = marquee.w - start;
+    if (first > MARQUEE_WIDTH) {
+        first = MARQUEE_WIDTH;
+    }
+    SDL_Rect src = {start, 0, first, marquee.h};
+    SDL_Rect dst = {x, y, first, marquee.h};
+    renderer.drawTexture(marquee.texture, &src, dst, color);
+    if (first < MARQUEE_WIDTH) {
+        SDL_Rect wrapSrc = {0, 0, MARQUEE_WIDTH - first, marquee.h};
+        SDL_Rect wrapDst = {x + first, y, MARQUEE_WIDTH - first, marquee.h};
+        renderer.drawTexture(marquee.texture, &wrapSrc, wrapDst, color);
+    }
+}
+
+void ListView::draw(size_t count, const LabelFunction& label, size_t selected, int scrollOffset) {
+    size_t begin = selected / PAGE_SIZE * PAGE_SIZE;
+    size_t end = std::min(count, begin + PAGE_SIZE);
+    if (selected >= count) {
+        marqueeScrolls = false;
+    }
+    for (size_t i = begin; i < end; i++) {
+        int slot = i - begin;
+        int x = ORIGIN + slot / ROWS_PER_COLUMN * COLUMN_WIDTH;
+        int y = ORIGIN + slot % ROWS_PER_COLUMN * ROW_HEIGHT;
+        std::string_view text = label(i);
+        if (i == selected) {
+            drawMarquee(x, y, text, scrollOffset, currentTheme.highlightColor);
+            continue;
+        }
+        // Only a slot whose label changed (a new page, or new rows) is rasterized again.
+        Row& row = rows[slot];
+        if (row.text != text) {
+            build(row, text, false);
+        }
+        if (row.texture) {
+            SDL_Rect dst = {x, y, row.w, row.h};
+            renderer.drawTexture(row.texture, nullptr, dst, currentTheme.textColor);
+        }
+    }
+}
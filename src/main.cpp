@@ -4,92 +4,45 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <memory>
 #include "theme_manager.h"
 #include "renderer.h"
 #include "download_manager.h"
 #include "game_controller.h"
 #include "ui_manager.h"
+#include "frame_pacer.h"
+#include "catalog_loader.h"
+#include "extraction_queue.h"
+#include "catalog_index.h"
+#include "catalog_indexer.h"
+#include "search_index.h"
+#include "on_screen_keyboard.h"
+#include "transfer_scheduler.h"
+#include "transfer_stats.h"
+#include "batch_download.h"
+#include "artwork_loader.h"
 #include "types.h"
 #include "utils.h"
 #include "config.h"
 
 
-std::atomic<int> downloadProgress(0);
-std::atomic<bool> isDownloading(false);
-
-std::queue<std::pair<std::string, std::string>> downloadQueue;
-std::vector<std::string> queuedGameTitles;
-
-std::mutex queueMutex;
-std::condition_variable queueCV;
-
-bool isUnzipping = false;
-
-
-void downloadGameThread(const std::string& console, const std::string& url, const std::string& gameTitle) {
-
-    isDownloading = true;
-    downloadProgress = 0;
-
-    int res = downloadGame(console, getHtml(url));
-
-    if (res == 0) {
-        std::cout << "Game downloaded successfully: " << gameTitle << std::endl;
-    } else {
-        std::cerr << "Failed to download game: " << gameTitle << std::endl;
-    }
-
-    isDownloading = false;
-    queueCV.notify_one();
-}
-
-int unzipGamesThread() {
-
-    isUnzipping = true;
-
-    int res = unzipGames("PlayStation");
-    if (res == 0) {
-        std::cout << "PlayStation Games Extracted Successfully" << std::endl;
-    } else {
-        std::cerr << "Failed to unzip one or more games" << std::endl;
-    }
-
-    res = unzipGames("PlayStation Portable");
-    if (res == 0) {
-        std::cout << "PSP Games Extracted Successfully" << std::endl;
-    } else {
-        std::cerr << "Failed to unzip one or more games" << std::endl;
-    }
-
-    isUnzipping = false;
-    return 0;
+std::string letterUrl(const Console& console, const std::vector<Filter>& filters, int filter) {
+    return "https://vimm.net" + console.url + "/" + filters[filter].value;
 }
 
 
-void processDownloadQueue() {
-    while (true) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        queueCV.wait(lock, [] { return !downloadQueue.empty() || !isDownloading; });
-
-        if (!downloadQueue.empty()) {
-            auto [console, url] = downloadQueue.front();
-            downloadQueue.pop();
-            std::string gameTitle = queuedGameTitles.front();
-            lock.unlock();
-
-            downloadGameThread(console, url, gameTitle);
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queuedGameTitles.erase(queuedGameTitles.begin());
-        }
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--batch") {
+        return runBatchDownload(argv[2]);
     }
-}
 
-int main(int argc, char* argv[]) {
+    // Once for the process: pages are parsed on several threads from here on.
+    xmlInitParser();
+    LIBXML_TEST_VERSION
 
     ThemeManager::applyTheme(ThemeManager::purpleTheme);
 
-    std::string htmlConsoles = getHtml("https://vimm.net/vault");
-    std::vector<Console> consoles = parseHTML(htmlConsoles);
+    std::vector<Console> consoles = parseHTML(*getCatalogHtml("https://vimm.net/vault"));
 
     
     Renderer renderer;
@@ -117,15 +70,46 @@ int main(int argc, char* argv[]) {
         Filter("T"), Filter("U"), Filter("V"), Filter("W"), Filter("X"), Filter("Y"), Filter("Z")
     };
 
-    std::thread queueThread(processDownloadQueue);
-    queueThread.detach();
+    ExtractionQueue extractionQueue(CACHE_DIR "/extracted.manifest");
+    DownloadManager downloadManager(&extractionQueue);
+    CatalogIndexer catalogIndexer(consoles, nullptr);
+    CatalogIndex catalogIndex;
+
+    // Search mode: the catalogs being searched, the console each one belongs
+    // to, and the current results.
+    bool showSearch = false;
+    bool searchKeyboard = true;
+    std::string searchScope;
+    OnScreenKeyboard keyboard;
+    SearchIndex searchIndex;
+    std::vector<std::unique_ptr<CatalogIndex>> searchCatalogs;
+    std::vector<int> searchConsoles;
+    std::vector<SearchHit> searchHits;
+    GameList searchGames;
+    int selectedResult = 0;
+
+    // Bandwidth cap presets stepped through with the shoulder buttons.
+    const std::vector<long long> capPresets = {0, 4096 * 1024, 2048 * 1024, 1024 * 1024, 512 * 1024, 256 * 1024};
+    TransferScheduler& scheduler = TransferScheduler::instance();
+    size_t capPreset = 0;
+    for (size_t i = 0; i < capPresets.size(); i++) {
+        if (capPresets[i] == scheduler.globalLimit()) {
+            capPreset = i;
+        }
+    }
 
     SDL_Event e;
     bool quit = false;
     int selectedConsole = 0;
     int selectedGame = 0;
     int selectedFilter = 0;
-    std::vector<Game> games;
+    // A letter is either a slice of the mapped index or a page being loaded
+    // into games; the helpers below read whichever is showing.
+    GameList games;
+    CatalogIndex::Slice indexedGames;
+    auto gameCount = [&]() { return indexedGames.empty() ? games.size() : indexedGames.size(); };
+    auto gameTitle = [&](size_t i) { return indexedGames.empty() ? games.title(i) : indexedGames.title(i); };
+    auto gameUrl = [&](size_t i) { return indexedGames.empty() ? games.url(i) : indexedGames.url(i); };
     bool showGames = false;
     bool showFilters = false;
     Uint32 lastButtonPressTime = 0;
@@ -135,23 +119,162 @@ int main(int argc, char* argv[]) {
     bool dpadUpPressed = false;
     bool dpadDownPressed = false;
 
-    while (!quit) {
-        static int scrollOffset = 0;
-        static int frameCount = 0;
-        frameCount++;
-        if (frameCount % 8 == 0) {
-            scrollOffset++;
+    // Nothing is redrawn unless one of these changes or an event arrives.
+    FramePacer pacer;
+    int scrollOffset = 0;
+    Uint32 nextScrollTime = SDL_GetTicks() + MARQUEE_INTERVAL_MS;
+    unsigned int shownDownloads = downloadManager.version();
+    unsigned int shownExtractions = extractionQueue.version();
+
+    // The catalog worker wakes the loop through the event queue.
+    Uint32 catalogEvent = SDL_RegisterEvents(1);
+    CatalogLoader catalogLoader([catalogEvent] {
+        SDL_Event event = {};
+        event.type = catalogEvent;
+        SDL_PushEvent(&event);
+    });
+
+    // Box art of the selected game, decoded off the render thread.
+    Uint32 artworkEvent = SDL_RegisterEvents(1);
+    ArtworkLoader artworkLoader([artworkEvent] {
+        SDL_Event event = {};
+        event.type = artworkEvent;
+        SDL_PushEvent(&event);
+    });
+    const SDL_Rect artRect = {SCREEN_WIDTH / 2 + 20, 20, SCREEN_WIDTH / 2 - 40, SCREEN_HEIGHT - 40};
+    std::string requestedArt;
+    std::vector<ArtworkLoader::Ready> readyArt;
+
+    auto openSearch = [&](bool allConsoles) {
+        searchCatalogs.clear();
+        searchConsoles.clear();
+        for (size_t i = 0; i < consoles.size(); i++) {
+            if (!allConsoles && (int)i != selectedConsole) {
+                continue;
+            }
+            std::unique_ptr<CatalogIndex> catalog(new CatalogIndex());
+            if (catalog->open(CatalogIndex::pathFor(consoles[i]))) {
+                searchCatalogs.push_back(std::move(catalog));
+                searchConsoles.push_back(i);
+            }
+        }
+        std::vector<const CatalogIndex*> catalogs;
+        for (const auto& catalog : searchCatalogs) {
+            catalogs.push_back(catalog.get());
+        }
+        searchIndex.build(catalogs);
+        searchScope = allConsoles ? "all consoles" : consoles[selectedConsole].name;
+        if (searchIndex.size() == 0) {
+            searchScope += " (not indexed yet)";
+        }
+        keyboard.clear();
+        searchHits.clear();
+        searchGames.clear();
+        selectedResult = 0;
+        searchKeyboard = true;
+        showSearch = true;
+    };
+
+    auto runSearch = [&]() {
+        searchHits = searchIndex.query(keyboard.text(), SEARCH_RESULT_LIMIT);
+        searchGames.clear();
+        for (const SearchHit& hit : searchHits) {
+            Game game = searchCatalogs[hit.catalog]->game(hit.record);
+            if (searchCatalogs.size() > 1) {
+                game.title += " [" + consoles[searchConsoles[hit.catalog]].name + "]";
+            }
+            searchGames.add(game);
         }
-        while (SDL_PollEvent(&e)) {
+        selectedResult = 0;
+        scrollOffset = 0;
+    };
+
+    auto closeSearch = [&]() {
+        showSearch = false;
+        searchIndex.clear();
+        searchCatalogs.clear();
+        searchConsoles.clear();
+        searchHits.clear();
+        searchGames.clear();
+    };
+
+    auto stepResult = [&](int dy) {
+        if (!searchGames.empty()) {
+            selectedResult = (selectedResult + dy + searchGames.size()) % searchGames.size();
+            scrollOffset = 0;
+        }
+    };
+
+    while (!quit) {
+        bool gotEvent = pacer.waitEvent(e);
+        while (gotEvent) {
             if (e.type == SDL_QUIT) {
                 quit = true;
+            } else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                renderer.invalidateFrame();
+                pacer.invalidate();
+            } else if (e.type == SDL_WINDOWEVENT || e.type == catalogEvent || e.type == artworkEvent) {
+                pacer.invalidate();
             } else if (e.type == SDL_CONTROLLERBUTTONDOWN || e.type == SDL_CONTROLLERBUTTONUP) {
+                pacer.invalidate();
                 Uint32 currentTime = SDL_GetTicks();
                 if (e.type == SDL_CONTROLLERBUTTONDOWN) {
                     lastButtonPressTime = currentTime;
                     std::cout << "Controller button pressed: " << (int)e.cbutton.button << std::endl;
                     if (e.cbutton.button == 3) {
                         quit = true;
+                    } else if (e.cbutton.button == SDL_CONTROLLER_BUTTON_LEFTSHOULDER || e.cbutton.button == SDL_CONTROLLER_BUTTON_RIGHTSHOULDER) {
+                        // Left tightens the cap, right loosens it.
+                        if (e.cbutton.button == SDL_CONTROLLER_BUTTON_LEFTSHOULDER && capPreset + 1 < capPresets.size()) {
+                            capPreset++;
+                        } else if (e.cbutton.button == SDL_CONTROLLER_BUTTON_RIGHTSHOULDER && capPreset > 0) {
+                            capPreset--;
+                        }
+                        scheduler.setGlobalLimit(capPresets[capPreset]);
+                    } else if (e.cbutton.button == SDL_CONTROLLER_BUTTON_START) {
+                        renderer.toggleOverlay();
+                    } else if (e.cbutton.button == 2) {
+                        // From the console list search everything, otherwise the open console.
+                        if (showSearch) {
+                            closeSearch();
+                        } else {
+                            openSearch(!showGames && !showFilters);
+                        }
+                    } else if (showSearch && searchKeyboard) {
+                        int button = e.cbutton.button;
+                        if (button == SDL_CONTROLLER_BUTTON_DPAD_UP || button == SDL_CONTROLLER_BUTTON_DPAD_DOWN) {
+                            keyboard.move(0, button == SDL_CONTROLLER_BUTTON_DPAD_UP ? -1 : 1);
+                        } else if (button == SDL_CONTROLLER_BUTTON_DPAD_LEFT || button == SDL_CONTROLLER_BUTTON_DPAD_RIGHT) {
+                            keyboard.move(button == SDL_CONTROLLER_BUTTON_DPAD_LEFT ? -1 : 1, 0);
+                        } else if (button == 0) {
+                            OnScreenKeyboard::Action action = keyboard.press();
+                            if (action == OnScreenKeyboard::Action::Done) {
+                                searchKeyboard = searchGames.empty();
+                            } else if (action != OnScreenKeyboard::Action::None) {
+                                runSearch();
+                            }
+                        } else if (button == 1) {
+                            if (keyboard.backspace()) {
+                                runSearch();
+                            } else {
+                                closeSearch();
+                            }
+                        }
+                    } else if (showSearch) {
+                        if (e.cbutton.button == SDL_CONTROLLER_BUTTON_DPAD_UP) {
+                            dpadUpPressed = true;
+                            stepResult(-1);
+                        } else if (e.cbutton.button == SDL_CONTROLLER_BUTTON_DPAD_DOWN) {
+                            dpadDownPressed = true;
+                            stepResult(1);
+                        } else if (e.cbutton.button == 0 && !searchGames.empty()) {
+                            const SearchHit& hit = searchHits[selectedResult];
+                            Game game = searchCatalogs[hit.catalog]->game(hit.record);
+                            std::cout << "Queueing search result for download: " << game.title << std::endl;
+                            downloadManager.queueDownload(consoles[searchConsoles[hit.catalog]].name, "https://vimm.net" + game.url, game.title);
+                        } else if (e.cbutton.button == 1) {
+                            searchKeyboard = true;
+                        }
                     } else if (e.cbutton.button == SDL_CONTROLLER_BUTTON_DPAD_UP) {
                         dpadUpPressed = true;
                         if (!showGames && !showFilters) {
@@ -160,8 +283,8 @@ int main(int argc, char* argv[]) {
                         } else if (showFilters) {
                             selectedFilter = (selectedFilter - 1 + filters.size()) % filters.size();
                             scrollOffset = 0;
-                        } else if (showGames) {
-                            selectedGame = (selectedGame - 1 + games.size()) % games.size();
+                        } else if (showGames && gameCount() > 0) {
+                            selectedGame = (selectedGame - 1 + gameCount()) % gameCount();
                             scrollOffset = 0;
                         }
                     } else if (e.cbutton.button == SDL_CONTROLLER_BUTTON_DPAD_DOWN) {
@@ -172,45 +295,60 @@ int main(int argc, char* argv[]) {
                         } else if (showFilters) {
                             selectedFilter = (selectedFilter + 1) % filters.size();
                             scrollOffset = 0;
-                        } else if (showGames) {
-                            selectedGame = (selectedGame + 1) % games.size();
+                        } else if (showGames && gameCount() > 0) {
+                            selectedGame = (selectedGame + 1) % gameCount();
                             scrollOffset = 0;
                         }
                     } else if (e.cbutton.button == 0) {
                         if (!showFilters && !showGames) {
                             showFilters = true;
+                            // Letters come straight from the crawled index when there is one.
+                            indexedGames = CatalogIndex::Slice();
+                            catalogIndex.open(CatalogIndex::pathFor(consoles[selectedConsole]));
+                        } else if (showFilters && catalogIndex.isOpen()) {
+                            games.clear();
+                            indexedGames = catalogIndex.letter(selectedFilter);
+                            showGames = true;
+                            selectedGame = 0;
+                            showFilters = false;
                         } else if (showFilters) {
                             std::cout << "Selected console: " << consoles[selectedConsole].name << std::endl;
-                            std::cout << "https://vimm.net" + consoles[selectedConsole].url + "/" + filters[selectedFilter].value << std::endl;
-                            std::string htmlGames = getHtml("https://vimm.net" + consoles[selectedConsole].url + "/" + filters[selectedFilter].value);
-                            games = parseGamesHTML(htmlGames);
-                            std::cout << "Number of games parsed: " << games.size() << std::endl;
+                            std::cout << letterUrl(consoles[selectedConsole], filters, selectedFilter) << std::endl;
+                            games.clear();
+                            indexedGames = CatalogIndex::Slice();
+                            // Warm the letters either side so stepping through them is instant.
+                            std::vector<std::string> neighbours;
+                            if (selectedFilter + 1 < (int)filters.size()) {
+                                neighbours.push_back(letterUrl(consoles[selectedConsole], filters, selectedFilter + 1));
+                            }
+                            if (selectedFilter > 0) {
+                                neighbours.push_back(letterUrl(consoles[selectedConsole], filters, selectedFilter - 1));
+                            }
+                            catalogLoader.load(letterUrl(consoles[selectedConsole], filters, selectedFilter), neighbours);
                             showGames = true;
                             selectedGame = 0;
                             showFilters = false;
-                        } else if (showGames && !games.empty()) {
-                            std::cout << "Selected game: " << games[selectedGame].title << std::endl;
+                        } else if (showGames && gameCount() > 0) {
+                            std::string title(gameTitle(selectedGame));
+                            std::cout << "Selected game: " << title << std::endl;
                             std::cout << "Queueing game for download..." << std::endl;
 
-                            {
-                                std::lock_guard<std::mutex> lock(queueMutex);
-                                downloadQueue.push({consoles[selectedConsole].name, "https://vimm.net" + games[selectedGame].url});
-                                queuedGameTitles.push_back(games[selectedGame].title);
-                            }
-                            queueCV.notify_one();
+                            downloadManager.queueDownload(consoles[selectedConsole].name, "https://vimm.net" + std::string(gameUrl(selectedGame)), title);
                         }
                     } else if (e.cbutton.button == 1) {
                         if (showGames) {
                             showGames = false;
                             showFilters = true;
+                            catalogLoader.cancel();
                         } else if (showFilters) {
                             showFilters = false;
                         }
                     } else if (e.cbutton.button == 4) {
-                        // Unzipping PS games
-
-                        std::thread unzipThread(unzipGamesThread, std::ref(renderer));
-                        unzipThread.detach();
+                        // Extract archives already in the selected console's folder
+                        std::string romPath = romPathFor(consoles[selectedConsole].name);
+                        if (!romPath.empty()) {
+                            extractionQueue.scan(romPath);
+                        }
 
                     }
                 } else if (e.type == SDL_CONTROLLERBUTTONUP) {
@@ -221,70 +359,154 @@ int main(int argc, char* argv[]) {
                     }
                 }
             }
+            gotEvent = SDL_PollEvent(&e);
         }
 
         // Handle button hold for D-Pad
         Uint32 currentTime = SDL_GetTicks();
         if (dpadUpPressed && (currentTime - lastButtonPressTime) >= buttonPressDelay) {
             lastButtonPressTime = currentTime;
-            if (!showGames && !showFilters) {
+            pacer.invalidate();
+            if (showSearch) {
+                stepResult(-1);
+            } else if (!showGames && !showFilters) {
                 selectedConsole = (selectedConsole - 1 + consoles.size()) % consoles.size();
                 scrollOffset = 0;
             } else if (showFilters) {
                 selectedFilter = (selectedFilter - 1 + filters.size()) % filters.size();
                 scrollOffset = 0;
-            } else if (showGames) {
-                selectedGame = (selectedGame - 1 + games.size()) % games.size();
+            } else if (showGames && gameCount() > 0) {
+                selectedGame = (selectedGame - 1 + gameCount()) % gameCount();
                 scrollOffset = 0;
             }
         } else if (dpadDownPressed && (currentTime - lastButtonPressTime) >= buttonPressDelay) {
             lastButtonPressTime = currentTime;
-            if (!showGames && !showFilters) {
+            pacer.invalidate();
+            if (showSearch) {
+                stepResult(1);
+            } else if (!showGames && !showFilters) {
                 selectedConsole = (selectedConsole + 1) % consoles.size();
                 scrollOffset = 0;
             } else if (showFilters) {
                 selectedFilter = (selectedFilter + 1) % filters.size();
                 scrollOffset = 0;
-            } else if (showGames) {
-                selectedGame = (selectedGame + 1) % games.size();
+            } else if (showGames && gameCount() > 0) {
+                selectedGame = (selectedGame + 1) % gameCount();
                 scrollOffset = 0;
             }
         }
-        renderer.clear();
+        if (dpadUpPressed || dpadDownPressed) {
+            pacer.wakeAt(lastButtonPressTime + buttonPressDelay);
+        }
+
+        // Marquee of the selected entry advances on a clock, not per frame,
+        // and only while something is moving: an overflowing label or the
+        // loading indicator.
+        if (uiManager.marqueeScrolls() || (showGames && catalogLoader.loading())) {
+            if (SDL_TICKS_PASSED(currentTime, nextScrollTime)) {
+                scrollOffset++;
+                nextScrollTime = currentTime + MARQUEE_INTERVAL_MS;
+                pacer.invalidate();
+            }
+            pacer.wakeAt(nextScrollTime);
+        }
+
+        // Show whatever part of the letter page has been parsed so far.
+        if (showGames && catalogLoader.drain(games)) {
+            pacer.invalidate();
+        }
+
+        // When the selection moves, ask for its art and the next few games';
+        // anything still queued for the old selection is dropped.
+        std::string artUrl;
+        if (showGames && !showSearch && selectedGame < (int)gameCount()) {
+            artUrl = ArtworkLoader::boxArtUrl(gameUrl(selectedGame));
+        }
+        if (artUrl != requestedArt) {
+            requestedArt = artUrl;
+            std::string selectedArt = renderer.textures().find(artUrl, artRect.w, artRect.h) ? "" : artUrl;
+            std::vector<std::string> prefetch;
+            for (int i = 1; !artUrl.empty() && i <= ARTWORK_PREFETCH && selectedGame + i < (int)gameCount(); i++) {
+                std::string url = ArtworkLoader::boxArtUrl(gameUrl(selectedGame + i));
+                if (!renderer.textures().find(url, artRect.w, artRect.h)) {
+                    prefetch.push_back(url);
+                }
+            }
+            artworkLoader.request(selectedArt, prefetch, artRect.w, artRect.h);
+        }
+        if (artworkLoader.drain(readyArt)) {
+            for (const auto& art : readyArt) {
+                renderer.textures().adopt(art.url, art.w, art.h, art.surface);
+            }
+            readyArt.clear();
+            pacer.invalidate();
+        }
+
+        // Worker threads only publish counters, so poll them while they run.
+        if (downloadManager.version() != shownDownloads || extractionQueue.version() != shownExtractions) {
+            shownDownloads = downloadManager.version();
+            shownExtractions = extractionQueue.version();
+            pacer.invalidate();
+        }
+        if (downloadManager.busy() || extractionQueue.busy()) {
+            pacer.wakeAt(currentTime + STATUS_POLL_MS);
+        }
+
+        if (quit || !pacer.render()) {
+            continue;
+        }
+
         const int leftSectionWidth = SCREEN_WIDTH / 2;
         const int rightSectionWidth = SCREEN_WIDTH / 2;
         const int offset = 10;
         const int cornerRadius = 20;
         const int borderThickness = 5;
         SDL_Rect leftBox = {offset, offset, leftSectionWidth - 2 * offset, SCREEN_HEIGHT - 2 * offset};
-        renderer.drawRoundedRect(leftBox, cornerRadius, borderThickness);
-        if (!showGames && !showFilters) {
+        SDL_Rect rightBox = {leftSectionWidth + offset, offset, rightSectionWidth - 2 * offset, SCREEN_HEIGHT - 2 * offset};
+        renderer.drawFrame({leftBox, rightBox}, cornerRadius, borderThickness);
+        if (showSearch) {
+            uiManager.drawGameList(searchGames, selectedResult, scrollOffset);
+            uiManager.drawSearch(keyboard, searchScope, searchIndex.matchCount(), searchKeyboard);
+        } else if (!showGames && !showFilters) {
             uiManager.drawConsoleList(consoles, selectedConsole, scrollOffset);
         } else if (showFilters) {
             uiManager.drawFilterList(filters, selectedFilter, scrollOffset);
         } else if (showGames) {
-            uiManager.drawGameList(games, selectedGame, scrollOffset);
+            if (indexedGames.empty()) {
+                uiManager.drawGameList(games, selectedGame, scrollOffset);
+            } else {
+                uiManager.drawGameList(indexedGames, selectedGame, scrollOffset);
+            }
+            if (catalogLoader.loading()) {
+                uiManager.drawLoadingIndicator(games.size(), scrollOffset);
+            }
         }
-        SDL_Rect rightBox = {leftSectionWidth + offset, offset, rightSectionWidth - 2 * offset, SCREEN_HEIGHT - 2 * offset};
-        renderer.drawRoundedRect(rightBox, cornerRadius, borderThickness);
-        if (!showGames && !showFilters && selectedConsole < consoles.size()) {
-            renderer.drawImage("res/placeholder.png", {leftSectionWidth + offset + 10, offset + 10, rightSectionWidth - 2 * offset - 20, SCREEN_HEIGHT - 2 * offset - 20});
-        } else if (showGames && selectedGame < games.size()) {
+        if (showSearch) {
+            // The keyboard takes the right panel.
+        } else if (!showGames && !showFilters && selectedConsole < consoles.size()) {
             renderer.drawImage("res/placeholder.png", {leftSectionWidth + offset + 10, offset + 10, rightSectionWidth - 2 * offset - 20, SCREEN_HEIGHT - 2 * offset - 20});
+        } else if (showGames && selectedGame < (int)gameCount()) {
+            if (!renderer.drawCachedImage(requestedArt, artRect)) {
+                renderer.drawImage("res/placeholder.png", artRect);
+            }
         }
-        if (isDownloading) {
-            uiManager.drawProgressBar(downloadProgress, queuedGameTitles[0], queuedGameTitles);
-        }
-
-        if (isUnzipping) {
-            renderer.drawMessageBox("Extracting Games from PSP and PS Folders");
+        int row = uiManager.drawBandwidthCap(scheduler.globalLimit(), 0);
+        std::vector<DownloadItem> downloads = downloadManager.snapshot();
+        row = uiManager.drawDownloads(downloads, row);
+        uiManager.drawExtractions(extractionQueue.snapshot(), row);
+        if (renderer.overlayVisible()) {
+            uiManager.drawStatsOverlay(downloads, TransferStats::instance().averageTimeToFirstByte(), pacer.frameTime());
         }
 
+        pacer.drawn();
         renderer.present();
-    
-    } 
+        pacer.presented();
+    }
 
     std::cout << "Cleaning up..." << std::endl;
+    pacer.report(true);
+    std::cout << "Texture cache: " << renderer.textures().hits() << " hits, " << renderer.textures().misses() << " misses, "
+              << renderer.textures().bytesUsed() / 1024 << " KiB" << std::endl;
 
     std::cout << "Exiting..." << std::endl;
 
@@ -0,0 +1,56 @@
+#include "on_screen_keyboard.h"
+
+OnScreenKeyboard::OnScreenKeyboard()
+    : keys({"ABCDEFGHIJ", "KLMNOPQRST", "UVWXYZ0123", "456789-&:!", "_<>"}), cursorRow(0), cursorColumn(0) {}
+
+void OnScreenKeyboard::move(int dx, int dy) {
+    int rowCount = keys.size();
+    cursorRow = (cursorRow + dy + rowCount) % rowCount;
+    int width = keys[cursorRow].size();
+    if (dy != 0 && cursorColumn >= width) {
+        cursorColumn = width - 1;
+    }
+    cursorColumn = (cursorColumn + dx + width) % width;
+}
+
+OnScreenKeyboard::Action OnScreenKeyboard::press() {
+    char key = keys[cursorRow][cursorColumn];
+    if (key == DONE_KEY) {
+        return Action::Done;
+    }
+    if (key == DELETE_KEY) {
+        return backspace() ? Action::Deleted : Action::None;
+    }
+    typed += key == SPACE_KEY ? ' ' : key;
+    return Action::Typed;
+}
+
+bool OnScreenKeyboard::backspace() {
+    if (typed.empty()) {
+        return false;
+    }
+    typed.pop_back();
+    return true;
+}
+
+void OnScreenKeyboard::clear() {
+    typed.clear();
+    cursorRow = 0;
+    cursorColumn = 0;
+}
+
+const std::string& OnScreenKeyboard::text() const {
+    return typed;
+}
+
+const std::vector<std::string>& OnScreenKeyboard::rows() const {
+    return keys;
+}
+
+int OnScreenKeyboard::row() const {
+    return cursorRow;
+}
+
+int OnScreenKeyboard::column() const {
+    return cursorColumn;
+}
@@ -0,0 +1,336 @@
+#include "output_writer.h"
+#include "config.h"
+#include "crc32.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+static const size_t BUFFER_ALIGNMENT = 4096;
+
+static std::mutex totalsMutex;
+static OutputWriter::Stats allTotals;
+
+OutputWriter::OutputWriter() : fd(-1), failed(false), writing(0), stopping(false) {}
+
+OutputWriter::~OutputWriter() {
+    close();
+}
+
+bool OutputWriter::checkFreeSpace(const std::string& path, long long bytes, std::string& error) {
+    std::string directory = path.substr(0, path.find_last_of('/'));
+    if (directory.empty() || directory == path) {
+        directory = ".";
+    }
+    struct statvfs fs;
+    if (bytes <= 0 || statvfs(directory.c_str(), &fs) != 0) {
+        return true; // nothing to check against; let the writes find out
+    }
+    long long available = (long long)fs.f_bavail * fs.f_frsize;
+    if (available >= bytes) {
+        return true;
+    }
+    char message[256];
+    snprintf(message, sizeof(message), "Not enough free space in %s: need %.1f MB, %.1f MB free", directory.c_str(),
+             bytes / (1024.0 * 1024.0), available / (1024.0 * 1024.0));
+    error = message;
+    return false;
+}
+
+bool OutputWriter::open(const std::string& target, long long expectedSize, bool truncate) {
+    close();
+    path = target;
+    errorMessage.clear();
+    failed = false;
+    counters = Stats();
+
+    fd = ::open(path.c_str(), truncate ? (O_WRONLY | O_CREAT | O_TRUNC) : (O_WRONLY | O_CREAT), 0644);
+    if (fd < 0) {
+        return fail("cannot open " + path + ": " + strerror(errno));
+    }
+    if (expectedSize > 0) {
+        // Only the part not yet allocated has to fit.
+        struct stat st;
+        long long existing = fstat(fd, &st) == 0 ? st.st_size : 0;
+        std::string message;
+        if (!checkFreeSpace(path, expectedSize - existing, message)) {
+            ::close(fd);
+            fd = -1;
+            return fail(message);
+        }
+        // fallocate is called directly: posix_fallocate falls back to writing
+        // zeroes on filesystems without it (FAT on the SD card), which costs
+        // as much as the download. There the file is only sized, since a
+        // resume checks the .part file against the full length.
+        if (existing < expectedSize && fallocate(fd, 0, 0, expectedSize) != 0) {
+            if (ftruncate(fd, expectedSize) != 0) {
+                std::string reason = strerror(errno);
+                ::close(fd);
+                fd = -1;
+                return fail("cannot size " + path + ": " + reason);
+            }
+        }
+    }
+    stopping = false;
+    thread = std::thread(&OutputWriter::writeBehind, this);
+    return true;
+}
+
+bool OutputWriter::isOpen() const {
+    return fd >= 0;
+}
+
+bool OutputWriter::close() {
+    if (fd < 0) {
+        return !failed;
+    }
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+    bool ok = ::close(fd) == 0 && !failed;
+    fd = -1;
+
+    for (auto& buffer : buffers) {
+        free(buffer->data);
+    }
+    buffers.clear();
+    freeBuffers.clear();
+    channels.clear();
+    if (counters.flushes > 0) {
+        std::cout << "Wrote " << counters.bytesWritten / (1024 * 1024) << " MB to " << path << " in " << counters.flushes
+                  << " flushes (avg " << counters.flushMsTotal / counters.flushes << " ms, max " << counters.flushMsMax << " ms)"
+                  << std::endl;
+    }
+    return ok;
+}
+
+bool OutputWriter::fail(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!failed) {
+        errorMessage = message;
+        std::cerr << "Write failed: " << message << std::endl;
+    }
+    failed = true;
+    cv.notify_all();
+    return false;
+}
+
+const std::string& OutputWriter::error() const {
+    return errorMessage;
+}
+
+int OutputWriter::channel(long long offset, uint32_t crc) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto added = std::make_unique<Channel>();
+    added->position = offset;
+    added->durable = offset;
+    added->crc = crc;
+    channels.push_back(std::move(added));
+    return channels.size() - 1;
+}
+
+OutputWriter::Buffer* OutputWriter::takeBuffer() {
+    std::unique_lock<std::mutex> lock(mutex);
+    // Every channel may be holding a partly filled buffer, so the cap grows
+    // with them; past it the network threads wait for the card.
+    size_t limit = std::max<size_t>(OUTPUT_BUFFER_COUNT, channels.size() * 2);
+    cv.wait(lock, [this, limit] { return failed || !freeBuffers.empty() || buffers.size() < limit; });
+    if (failed) {
+        return nullptr;
+    }
+    if (!freeBuffers.empty()) {
+        Buffer* buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        return buffer;
+    }
+    void* memory = nullptr;
+    if (posix_memalign(&memory, BUFFER_ALIGNMENT, OUTPUT_BUFFER_SIZE) != 0) {
+        lock.unlock();
+        fail("out of memory for write buffers");
+        return nullptr;
+    }
+    buffers.push_back(std::make_unique<Buffer>());
+    buffers.back()->data = static_cast<char*>(memory);
+    return buffers.back().get();
+}
+
+void OutputWriter::submit(Buffer* buffer) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(buffer);
+    }
+    cv.notify_all();
+}
+
+bool OutputWriter::write(int id, const char* data, size_t size) {
+    Channel* ch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ch = channels[id].get();
+    }
+    while (size > 0) {
+        if (failed) {
+            return false;
+        }
+        if (!ch->buffer) {
+            ch->buffer = takeBuffer();
+            if (!ch->buffer) {
+                return false;
+            }
+            ch->buffer->fill = 0;
+            ch->buffer->offset = ch->position;
+            ch->buffer->channel = id;
+        }
+        Buffer* buffer = ch->buffer;
+        size_t take = std::min(size, (size_t)OUTPUT_BUFFER_SIZE - buffer->fill);
+        memcpy(buffer->data + buffer->fill, data, take);
+        buffer->fill += take;
+        ch->position += take;
+        data += take;
+        size -= take;
+        if (buffer->fill == OUTPUT_BUFFER_SIZE) {
+            ch->buffer = nullptr;
+            submit(buffer);
+        }
+    }
+    return !failed;
+}
+
+void OutputWriter::seek(int id, long long offset) {
+    Channel* ch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ch = channels[id].get();
+    }
+    if (ch->buffer) {
+        submit(ch->buffer);
+        ch->buffer = nullptr;
+    }
+    ch->position = offset;
+}
+
+long long OutputWriter::durable(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return channels[id]->durable;
+}
+
+long long OutputWriter::durable(int id, uint32_t& crc) {
+    std::lock_guard<std::mutex> lock(mutex);
+    crc = channels[id]->crc;
+    return channels[id]->durable;
+}
+
+bool OutputWriter::flush() {
+    // Callers make sure no channel is being written meanwhile.
+    std::vector<Buffer*> partial;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& ch : channels) {
+            if (ch->buffer) {
+                partial.push_back(ch->buffer);
+                ch->buffer = nullptr;
+            }
+        }
+    }
+    for (Buffer* buffer : partial) {
+        submit(buffer);
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return failed || (queue.empty() && writing == 0); });
+    return !failed;
+}
+
+bool OutputWriter::sync() {
+    return fd >= 0 && fdatasync(fd) == 0;
+}
+
+bool OutputWriter::truncate(long long length) {
+    if (!flush()) {
+        return false;
+    }
+    if (ftruncate(fd, length) != 0) {
+        return fail("cannot truncate " + path + ": " + strerror(errno));
+    }
+    return true;
+}
+
+OutputWriter::Stats OutputWriter::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+OutputWriter::Stats OutputWriter::totals() {
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    return allTotals;
+}
+
+void OutputWriter::writeBehind() {
+    while (true) {
+        Buffer* buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            buffer = queue.front();
+            queue.pop_front();
+            writing++;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        size_t done = 0;
+        while (done < buffer->fill && !failed) {
+            ssize_t n = pwrite(fd, buffer->data + done, buffer->fill - done, buffer->offset + done);
+            if (n < 0) {
+                if (errno != EINTR) {
+                    fail("write to " + path + " failed: " + strerror(errno));
+                }
+                continue;
+            }
+            done += n;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Buffers of one channel arrive in order, so the CRC runs along with
+        // durable; one that does not continue it follows a seek.
+        uint32_t crc;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Channel* ch = channels[buffer->channel].get();
+            crc = ch->durable == buffer->offset ? ch->crc : 0;
+        }
+        crc = crc32Update(crc, buffer->data, done);
+
+        {
+            std::lock_guard<std::mutex> lock(totalsMutex);
+            allTotals.bytesWritten += done;
+            allTotals.flushes++;
+            allTotals.flushMsTotal += ms;
+            allTotals.flushMsMax = std::max(allTotals.flushMsMax, ms);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            channels[buffer->channel]->durable = buffer->offset + (long long)done;
+            channels[buffer->channel]->crc = crc;
+            counters.bytesWritten += done;
+            counters.flushes++;
+            counters.flushMsTotal += ms;
+            counters.flushMsMax = std::max(counters.flushMsMax, ms);
+            freeBuffers.push_back(buffer);
+            writing--;
+        }
+        cv.notify_all();
+    }
+}
@@ -1,10 +1,16 @@
 #include "renderer.h"
+#include <algorithm>
 #include <iostream>
 #include "config.h"
 
-Renderer::Renderer() : window(nullptr), renderer(nullptr), font(nullptr) {}
+Renderer::Renderer()
+    : window(nullptr), renderer(nullptr), font(nullptr), textureCache(TEXTURE_CACHE_BUDGET), overlay(false), frameTexture(nullptr),
+      frameRadius(0), frameThickness(0), frameThemeGeneration(0), frameWidth(0), frameHeight(0) {}
 
 Renderer::~Renderer() {
+    glyphAtlas.destroy();
+    textureCache.clear();
+    invalidateFrame();
     if (font) {
         TTF_CloseFont(font);
     }
@@ -33,7 +39,9 @@ bool Renderer::initialize() {
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    // Lets SDL merge the per-glyph copies from the atlas into few draw calls.
+    SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer) {
         SDL_DestroyWindow(window);
         std::cerr << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
@@ -52,10 +60,15 @@ bool Renderer::initialize() {
         return false;
     }
 
+    if (!glyphAtlas.build(renderer, font)) {
+        std::cerr << "Glyph atlas unavailable, rasterizing text per call" << std::endl;
+    }
+
     if (IMG_Init(IMG_INIT_PNG) == 0) {
         std::cerr << "IMG_Init Error: " << IMG_GetError() << std::endl;
         return false;
     }
+    textureCache.setRenderer(renderer);
 
     return true;
 }
@@ -70,6 +83,11 @@ void Renderer::present() {
 }
 
 void Renderer::drawText(const std::string& text, int x, int y, SDL_Color color) {
+    if (glyphAtlas.ready()) {
+        glyphAtlas.draw(text, x, y, color);
+        return;
+    }
+
     SDL_Surface* surface = TTF_RenderText_Solid(font, text.c_str(), color);
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
     SDL_Rect rect = {x, y, surface->w, surface->h};
@@ -78,6 +96,39 @@ void Renderer::drawText(const std::string& text, int x, int y, SDL_Color color)
     SDL_DestroyTexture(texture);
 }
 
+int Renderer::measureText(const std::string& text) {
+    if (glyphAtlas.ready()) {
+        return glyphAtlas.measure(text);
+    }
+    int w = 0, h = 0;
+    TTF_SizeText(font, text.c_str(), &w, &h);
+    return w;
+}
+
+SDL_Texture* Renderer::createTextTexture(const std::string& text, int& w, int& h) {
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* surface = text.empty() ? nullptr : TTF_RenderUTF8_Blended(font, text.c_str(), white);
+    if (!surface) {
+        return nullptr;
+    }
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    w = surface->w;
+    h = surface->h;
+    SDL_FreeSurface(surface);
+    if (!texture) {
+        std::cerr << "SDL_CreateTextureFromSurface Error: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+void Renderer::drawTexture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, SDL_Color color) {
+    SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(texture, color.a);
+    SDL_RenderCopy(renderer, texture, src, &dst);
+}
+
 void DrawFilledCircle(SDL_Renderer* renderer, int x, int y, int radius) {
     for (int w = 0; w < radius * 2; w++) {
         for (int h = 0; h < radius * 2; h++) {
@@ -111,33 +162,114 @@ void Renderer::drawRoundedRect(SDL_Rect rect, int radius, int thickness) {
     }
 }
 
-void Renderer::drawProgressBar(int progress, const std::string& title, const std::vector<std::string>& queuedTitles) {
+static bool sameRects(const std::vector<SDL_Rect>& a, const std::vector<SDL_Rect>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].w != b[i].w || a[i].h != b[i].h) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Renderer::invalidateFrame() {
+    if (frameTexture) {
+        SDL_DestroyTexture(frameTexture);
+        frameTexture = nullptr;
+    }
+}
+
+// Clears the screen and draws the rounded panels. The result is kept in a
+// render-target texture and reused until the theme, layout or output size
+// changes, so a normal frame costs one copy instead of thousands of points.
+void Renderer::drawFrame(const std::vector<SDL_Rect>& panels, int radius, int thickness) {
+    int width = 0, height = 0;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+
+    bool valid = frameTexture && frameThemeGeneration == themeGeneration && frameRadius == radius &&
+                 frameThickness == thickness && frameWidth == width && frameHeight == height && sameRects(framePanels, panels);
+    if (!valid) {
+        invalidateFrame();
+        if (SDL_RenderTargetSupported(renderer)) {
+            frameTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        }
+        if (frameTexture && SDL_SetRenderTarget(renderer, frameTexture) == 0) {
+            clear();
+            for (const auto& panel : panels) {
+                drawRoundedRect(panel, radius, thickness);
+            }
+            SDL_SetRenderTarget(renderer, nullptr);
+            SDL_SetTextureBlendMode(frameTexture, SDL_BLENDMODE_NONE);
+            framePanels = panels;
+            frameRadius = radius;
+            frameThickness = thickness;
+            frameThemeGeneration = themeGeneration;
+            frameWidth = width;
+            frameHeight = height;
+        } else {
+            invalidateFrame();
+        }
+    }
+
+    if (frameTexture) {
+        SDL_RenderCopy(renderer, frameTexture, nullptr, nullptr);
+        return;
+    }
+
+    // No render targets on this renderer: draw the frame directly.
+    clear();
+    for (const auto& panel : panels) {
+        drawRoundedRect(panel, radius, thickness);
+    }
+}
+
+void Renderer::drawProgressBar(int progress, const std::string& title, int row) {
+    // Rows stack upwards from the bottom of the right panel.
+    int y = SCREEN_HEIGHT - 10 - 60 - row * 70;
+
     // Outline For Progress Box
-    SDL_Rect fullBox = {SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 60, (SCREEN_WIDTH / 2 - 2 * 10 - 140), 25};
+    SDL_Rect fullBox = {SCREEN_WIDTH / 2 + 10 + 70, y, (SCREEN_WIDTH / 2 - 2 * 10 - 140), 25};
     SDL_SetRenderDrawColor(renderer, currentTheme.highlightColor.r, currentTheme.highlightColor.g, currentTheme.highlightColor.b, currentTheme.highlightColor.a);
     SDL_RenderDrawRect(renderer, &fullBox);
 
     // Define Progress Bar
-    SDL_Rect progressBar = {SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 60, (SCREEN_WIDTH / 2 - 2 * 10 - 140) * progress / 100, 25};
+    SDL_Rect progressBar = {SCREEN_WIDTH / 2 + 10 + 70, y, (SCREEN_WIDTH / 2 - 2 * 10 - 140) * progress / 100, 25};
     SDL_SetRenderDrawColor(renderer, currentTheme.progressBarColor.r, currentTheme.progressBarColor.g, currentTheme.progressBarColor.b, currentTheme.progressBarColor.a);
     SDL_RenderFillRect(renderer, &progressBar);
 
     SDL_Color color = currentTheme.textColor;
-    drawText(title, SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 90, color);
-
-    if (queuedTitles.size() > 1) {
-        drawText("Next: " + queuedTitles[1], SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 120, color);
-    }
+    drawText(title, SCREEN_WIDTH / 2 + 10 + 70, y - 30, color);
 }
 
 void Renderer::drawImage(const std::string& imagePath, SDL_Rect rect) {
-    SDL_Texture* imageTexture = IMG_LoadTexture(renderer, imagePath.c_str());
+    SDL_Texture* imageTexture = textureCache.get(imagePath, rect.w, rect.h);
     if (imageTexture) {
         SDL_RenderCopy(renderer, imageTexture, nullptr, &rect);
-        SDL_DestroyTexture(imageTexture);
     }
 }
 
+// Draws art that was uploaded with TextureCache::adopt() for this rect,
+// centred and scaled to fit. Returns false when it is not there (yet).
+bool Renderer::drawCachedImage(const std::string& key, SDL_Rect rect) {
+    SDL_Texture* texture = textureCache.find(key, rect.w, rect.h);
+    int w = 0, h = 0;
+    if (!texture || SDL_QueryTexture(texture, nullptr, nullptr, &w, &h) != 0 || w <= 0 || h <= 0) {
+        return false;
+    }
+    double scale = std::min((double)rect.w / w, (double)rect.h / h);
+    SDL_Rect dst = {0, 0, (int)(w * scale), (int)(h * scale)};
+    dst.x = rect.x + (rect.w - dst.w) / 2;
+    dst.y = rect.y + (rect.h - dst.h) / 2;
+    SDL_RenderCopy(renderer, texture, nullptr, &dst);
+    return true;
+}
+
+TextureCache& Renderer::textures() {
+    return textureCache;
+}
+
 void Renderer::drawMessageBox(const std::string& message) {
     // Define the dimensions of the message box
     int boxWidth = 400;
@@ -157,14 +289,32 @@ void Renderer::drawMessageBox(const std::string& message) {
     int textX = messageBox.x + 20;
     int textY = messageBox.y + (boxHeight / 2) - 10; // Adjust the Y position to center the text vertically
     drawText(message, textX, textY, textColor);
+}
 
-    // Present the message box
-    SDL_RenderPresent(renderer);
+void Renderer::toggleOverlay() {
+    overlay = !overlay;
+}
 
-    // Wait for 1 second
-    SDL_Delay(1000);
+bool Renderer::overlayVisible() const {
+    return overlay;
+}
 
-    // Clear the message box
-    clear();
-    present();
-}
\ No newline at end of file
+void Renderer::drawOverlay(const std::vector<std::string>& lines) {
+    if (!overlay) {
+        return;
+    }
+    // Top right corner of the right panel, dimmed so the art shows through.
+    const int lineHeight = 30;
+    int width = 0;
+    for (const auto& line : lines) {
+        width = std::max(width, measureText(line));
+    }
+    SDL_Rect box = {SCREEN_WIDTH - 10 - 30 - width - 20, 10 + 30, width + 20, (int)lines.size() * lineHeight + 10};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 192);
+    SDL_RenderFillRect(renderer, &box);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    for (size_t i = 0; i < lines.size(); i++) {
+        drawText(lines[i], box.x + 10, box.y + 5 + (int)i * lineHeight, currentTheme.textColor);
+    }
+}
@@ -0,0 +1,204 @@
+#include "response_buffer.h"
+#include "config.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool() : pooledBytes(0), allocationCount(0), reuseCount(0) {}
+
+BufferPool::~BufferPool() {
+    for (Block& block : freeBlocks) {
+        free(block.data);
+    }
+}
+
+BufferPool::Block BufferPool::acquire(size_t minimum) {
+    // Whole segments, so blocks of similar pages can stand in for each other.
+    size_t capacity = (std::max<size_t>(minimum, 1) + RESPONSE_SEGMENT_SIZE - 1) / RESPONSE_SEGMENT_SIZE * RESPONSE_SEGMENT_SIZE;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto best = freeBlocks.end();
+        for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+            if (it->capacity >= capacity && (best == freeBlocks.end() || it->capacity < best->capacity)) {
+                best = it;
+            }
+        }
+        if (best != freeBlocks.end()) {
+            Block block = *best;
+            freeBlocks.erase(best);
+            pooledBytes -= block.capacity;
+            reuseCount++;
+            block.size = 0;
+            return block;
+        }
+        allocationCount++;
+    }
+    Block block;
+    block.data = static_cast<char*>(malloc(capacity));
+    block.capacity = block.data ? capacity : 0;
+    return block;
+}
+
+void BufferPool::release(Block& block) {
+    if (!block.data) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pooledBytes + block.capacity <= RESPONSE_POOL_BYTES) {
+            pooledBytes += block.capacity;
+            freeBlocks.push_back(block);
+            block = Block();
+            return;
+        }
+    }
+    free(block.data);
+    block = Block();
+}
+
+size_t BufferPool::allocations() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return allocationCount;
+}
+
+size_t BufferPool::reuses() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reuseCount;
+}
+
+ResponseBuffer::ResponseBuffer() : total(0) {}
+
+ResponseBuffer::~ResponseBuffer() {
+    clear();
+}
+
+ResponseBuffer::ResponseBuffer(ResponseBuffer&& other) noexcept : blocks(std::move(other.blocks)), total(other.total) {
+    other.blocks.clear();
+    other.total = 0;
+}
+
+ResponseBuffer& ResponseBuffer::operator=(ResponseBuffer&& other) noexcept {
+    if (this != &other) {
+        clear();
+        blocks = std::move(other.blocks);
+        total = other.total;
+        other.blocks.clear();
+        other.total = 0;
+    }
+    return *this;
+}
+
+void ResponseBuffer::reserve(size_t bytes) {
+    if (blocks.empty() && bytes > 0) {
+        blocks.push_back(BufferPool::instance().acquire(bytes));
+    }
+}
+
+void ResponseBuffer::append(const char* data, size_t size) {
+    while (size > 0) {
+        if (blocks.empty() || blocks.back().size == blocks.back().capacity) {
+            blocks.push_back(BufferPool::instance().acquire(RESPONSE_SEGMENT_SIZE));
+            if (!blocks.back().data) {
+                blocks.pop_back();
+                return;
+            }
+        }
+        BufferPool::Block& block = blocks.back();
+        size_t take = std::min(size, block.capacity - block.size);
+        memcpy(block.data + block.size, data, take);
+        block.size += take;
+        total += take;
+        data += take;
+        size -= take;
+    }
+}
+
+bool ResponseBuffer::readFile(const std::string& path) {
+    clear();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    reserve(st.st_size);
+
+    // Straight into the reserved block; a file that grew meanwhile spills into segments.
+    char chunk[16384];
+    while (true) {
+        bool direct = !blocks.empty() && blocks.back().size < blocks.back().capacity;
+        char* target = direct ? blocks.back().data + blocks.back().size : chunk;
+        size_t room = direct ? blocks.back().capacity - blocks.back().size : sizeof(chunk);
+        ssize_t n = read(fd, target, room);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            close(fd);
+            return n == 0;
+        }
+        if (direct) {
+            blocks.back().size += n;
+            total += n;
+        } else {
+            append(chunk, n);
+        }
+    }
+}
+
+void ResponseBuffer::clear() {
+    for (BufferPool::Block& block : blocks) {
+        BufferPool::instance().release(block);
+    }
+    blocks.clear();
+    total = 0;
+}
+
+size_t ResponseBuffer::size() const {
+    return total;
+}
+
+bool ResponseBuffer::empty() const {
+    return total == 0;
+}
+
+bool ResponseBuffer::contiguous() const {
+    return blocks.size() <= 1;
+}
+
+const char* ResponseBuffer::data() const {
+    return blocks.empty() ? "" : blocks.front().data;
+}
+
+size_t ResponseBuffer::segmentCount() const {
+    return blocks.size();
+}
+
+const char* ResponseBuffer::segmentData(size_t index) const {
+    return blocks[index].data;
+}
+
+size_t ResponseBuffer::segmentSize(size_t index) const {
+    return blocks[index].size;
+}
+
+std::string ResponseBuffer::str() const {
+    std::string text;
+    text.reserve(total);
+    for (const BufferPool::Block& block : blocks) {
+        text.append(block.data, block.size);
+    }
+    return text;
+}
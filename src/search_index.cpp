@@ -0,0 +1,195 @@
+#include "search_index.h"
+#include "catalog_index.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+SearchIndex::SearchIndex() : lastMatches(0) {}
+
+std::string SearchIndex::normalize(const std::string& text) {
+    // Punctuation and case never matter for a title search; runs of anything
+    // else collapse to one space.
+    std::string out;
+    out.reserve(text.size());
+    bool space = true;
+    for (unsigned char c : text) {
+        if (isalnum(c)) {
+            out += (char)tolower(c);
+            space = false;
+        } else if (c == '\'') {
+            continue;
+        } else if (!space) {
+            out += ' ';
+            space = true;
+        }
+    }
+    if (!out.empty() && out.back() == ' ') {
+        out.pop_back();
+    }
+    return out;
+}
+
+void SearchIndex::trigrams(const std::string& normalized, std::vector<uint32_t>& out) {
+    // Padding with a leading space makes word starts their own trigrams.
+    std::string padded = " " + normalized + " ";
+    for (size_t i = 0; i + 3 <= padded.size(); i++) {
+        out.push_back(((uint32_t)(unsigned char)padded[i] << 16) | ((uint32_t)(unsigned char)padded[i + 1] << 8) |
+                      (unsigned char)padded[i + 2]);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void SearchIndex::clear() {
+    titles.clear();
+    entries.clear();
+    keys.clear();
+    postingOffsets.clear();
+    postings.clear();
+    hits.clear();
+    touched.clear();
+    lastMatches = 0;
+    lastQuery.clear();
+    lastCandidates.clear();
+}
+
+size_t SearchIndex::matchCount() const {
+    return lastMatches;
+}
+
+size_t SearchIndex::size() const {
+    return titles.size();
+}
+
+void SearchIndex::build(const std::vector<const CatalogIndex*>& catalogs) {
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    for (uint32_t c = 0; c < catalogs.size(); c++) {
+        for (uint32_t record = 0; record < catalogs[c]->size(); record++) {
+            entries.push_back({c, record});
+            titles.push_back(normalize(catalogs[c]->title(record)));
+        }
+    }
+
+    // (trigram, entry) pairs sorted once give every posting list in order.
+    std::vector<uint64_t> pairs;
+    std::vector<uint32_t> grams;
+    for (uint32_t id = 0; id < titles.size(); id++) {
+        grams.clear();
+        trigrams(titles[id], grams);
+        for (uint32_t gram : grams) {
+            pairs.push_back(((uint64_t)gram << 32) | id);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    postings.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        uint32_t gram = pairs[i] >> 32;
+        if (keys.empty() || keys.back() != gram) {
+            keys.push_back(gram);
+            postingOffsets.push_back(postings.size());
+        }
+        postings.push_back((uint32_t)pairs[i]);
+    }
+    postingOffsets.push_back(postings.size());
+    hits.assign(titles.size(), 0);
+    std::cout << "Search index: " << titles.size() << " titles, " << keys.size() << " trigrams in "
+              << elapsedMs(start) << " ms" << std::endl;
+}
+
+int SearchIndex::rank(uint32_t id, const std::string& needle, int shared, int total) const {
+    const std::string& title = titles[id];
+    int score = total > 0 ? shared * 1000 / total : 0;
+    size_t pos = title.find(needle);
+    if (pos != std::string::npos) {
+        score += 1000;
+        if (pos == 0) {
+            score += 500;
+        } else if (title[pos - 1] == ' ') {
+            score += 250;
+        }
+    }
+    // Among equal matches, shorter titles are closer to what was typed.
+    return score * 4 - (int)std::min<size_t>(title.size(), 200);
+}
+
+std::vector<SearchHit> SearchIndex::query(const std::string& text, size_t limit) {
+    std::string needle = normalize(text);
+    std::vector<SearchHit> results;
+    if (needle.empty() || titles.empty()) {
+        lastMatches = 0;
+        lastQuery.clear();
+        lastCandidates.clear();
+        return results;
+    }
+
+    std::vector<std::pair<int, uint32_t>> scored;
+    if (needle.size() < 3) {
+        // Too short for trigrams to discriminate: rank substring matches,
+        // narrowing the previous result set while the query only grows.
+        bool refine = !lastQuery.empty() && needle.compare(0, lastQuery.size(), lastQuery) == 0;
+        std::vector<uint32_t> candidates;
+        if (refine) {
+            candidates.swap(lastCandidates);
+        } else {
+            lastCandidates.clear();
+            candidates.resize(titles.size());
+            for (uint32_t id = 0; id < titles.size(); id++) {
+                candidates[id] = id;
+            }
+        }
+        for (uint32_t id : candidates) {
+            if (titles[id].find(needle) != std::string::npos) {
+                scored.push_back({rank(id, needle, 0, 0), id});
+                lastCandidates.push_back(id);
+            }
+        }
+    } else {
+        std::vector<uint32_t> grams;
+        trigrams(needle, grams);
+        for (uint32_t gram : grams) {
+            auto it = std::lower_bound(keys.begin(), keys.end(), gram);
+            if (it == keys.end() || *it != gram) {
+                continue;
+            }
+            size_t k = it - keys.begin();
+            for (uint32_t p = postingOffsets[k]; p < postingOffsets[k + 1]; p++) {
+                uint32_t id = postings[p];
+                if (hits[id]++ == 0) {
+                    touched.push_back(id);
+                }
+            }
+        }
+        // Typos cost a few trigrams each; require about half of them.
+        int total = grams.size();
+        int minimum = std::max(1, total / 2);
+        lastCandidates.clear();
+        for (uint32_t id : touched) {
+            if (hits[id] >= minimum) {
+                scored.push_back({rank(id, needle, hits[id], total), id});
+                lastCandidates.push_back(id);
+            }
+            hits[id] = 0;
+        }
+        touched.clear();
+    }
+    lastQuery = needle;
+    lastMatches = scored.size();
+
+    size_t count = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                      [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) {
+                          return a.first != b.first ? a.first > b.first : a.second < b.second;
+                      });
+    results.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        results.push_back(entries[scored[i].second]);
+    }
+    return results;
+}
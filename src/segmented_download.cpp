@@ -0,0 +1,507 @@
+#include "segmented_download.h"
+#include "http_client.h"
+#include "config.h"
+#include "crc32.h"
+#include "transfer_scheduler.h"
+#include "transfer_stats.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+bool parseHeaderLine(const std::string& line, const std::string& name, std::string& value) {
+    if (line.size() <= name.size() || line[name.size()] != ':' || strncasecmp(line.c_str(), name.c_str(), name.size()) != 0) {
+        return false;
+    }
+    size_t begin = line.find_first_not_of(" \t", name.size() + 1);
+    size_t end = line.find_last_not_of(" \t\r\n");
+    value = (begin == std::string::npos || end < begin) ? "" : line.substr(begin, end - begin + 1);
+    return true;
+}
+
+static std::string dispositionFilename(const std::string& value) {
+    size_t pos = value.find("filename=\"");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    size_t endPos = value.find('"', pos + 10);
+    if (endPos == std::string::npos) {
+        return "";
+    }
+    return value.substr(pos + 10, endPos - pos - 10);
+}
+
+static long responseCode(CurlApi& curl, CURL* handle) {
+    long code = 0;
+    curl.easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+    return code;
+}
+
+SegmentedDownload::SegmentedDownload(HttpClient& http, const std::string& url, const std::vector<std::string>& headers)
+    : http(http), curl(http.api()), url(url), headers(headers), headerList(nullptr), abortRequested(false), committedBytes(0), fileCrc(0) {}
+
+SegmentedDownload::~SegmentedDownload() {
+    if (headerList) {
+        curl.slist_free_all(headerList);
+    }
+}
+
+void SegmentedDownload::buildHeaderList() {
+    if (!headerList) {
+        for (const auto& header : headers) {
+            headerList = curl.slist_append(headerList, header.c_str());
+        }
+    }
+}
+
+const DownloadProbe& SegmentedDownload::info() const {
+    return probeInfo;
+}
+
+size_t SegmentedDownload::probeHeaderCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    DownloadProbe* probe = static_cast<DownloadProbe*>(userdata);
+    std::string line(ptr, size * nmemb);
+    std::string value;
+
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        // A new response (e.g. after a redirect) starts a fresh header block.
+        *probe = DownloadProbe();
+    } else if (parseHeaderLine(line, "Content-Range", value)) {
+        size_t slash = value.find('/');
+        if (slash != std::string::npos && value.compare(slash + 1, 1, "*") != 0) {
+            probe->contentLength = std::atoll(value.c_str() + slash + 1);
+            probe->acceptRanges = true;
+        }
+    } else if (parseHeaderLine(line, "Content-Length", value)) {
+        if (!probe->acceptRanges) {
+            probe->contentLength = std::atoll(value.c_str());
+        }
+    } else if (parseHeaderLine(line, "Content-Disposition", value)) {
+        probe->filename = dispositionFilename(value);
+    } else if (parseHeaderLine(line, "ETag", value)) {
+        probe->etag = value;
+    } else if (parseHeaderLine(line, "Last-Modified", value)) {
+        probe->lastModified = value;
+    }
+    return size * nmemb;
+}
+
+size_t SegmentedDownload::probeWriteCallback(char*, size_t size, size_t nmemb, void* userdata) {
+    DownloadProbe* probe = static_cast<DownloadProbe*>(userdata);
+    // A 206 answers the probe with a single byte; anything else is the full
+    // body, which we abort rather than downloading twice.
+    return probe->acceptRanges ? size * nmemb : 0;
+}
+
+bool SegmentedDownload::probe() {
+    CURL* handle = http.acquire();
+    if (!handle) {
+        return false;
+    }
+
+    buildHeaderList();
+
+    curl.easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl.easy_setopt(handle, CURLOPT_HTTPHEADER, headerList);
+    curl.easy_setopt(handle, CURLOPT_RANGE, "0-0");
+    curl.easy_setopt(handle, CURLOPT_HEADERFUNCTION, probeHeaderCallback);
+    curl.easy_setopt(handle, CURLOPT_HEADERDATA, &probeInfo);
+    curl.easy_setopt(handle, CURLOPT_WRITEFUNCTION, probeWriteCallback);
+    curl.easy_setopt(handle, CURLOPT_WRITEDATA, &probeInfo);
+
+    int res = curl.easy_perform(handle);
+    long code = responseCode(curl, handle);
+    http.release(handle);
+
+    if (res != CURLE_OK && res != CURLE_WRITE_ERROR) {
+        std::cerr << "Download probe failed: " << curl.easy_strerror(res) << std::endl;
+        return false;
+    }
+    if (code != 206) {
+        probeInfo.acceptRanges = false;
+    }
+
+    std::cout << "Probe: " << probeInfo.contentLength << " bytes, ranges "
+              << (probeInfo.acceptRanges ? "supported" : "not supported") << std::endl;
+    return true;
+}
+
+size_t SegmentedDownload::headerCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    Segment* segment = static_cast<Segment*>(userdata);
+    std::string line(ptr, size * nmemb);
+    std::string value;
+
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        size_t space = line.find(' ');
+        segment->status = space == std::string::npos ? 0 : std::atol(line.c_str() + space + 1);
+    }
+
+    // Only the unranged stream reads the filename; ranged segments already
+    // have it from the probe and must not race on it.
+    if (!segment->ranged && parseHeaderLine(line, "Content-Disposition", value)) {
+        std::string filename = dispositionFilename(value);
+        if (!filename.empty()) {
+            segment->owner->probeInfo.filename = filename;
+        }
+    }
+    return size * nmemb;
+}
+
+size_t SegmentedDownload::writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    Segment* segment = static_cast<Segment*>(userdata);
+    SegmentedDownload* owner = segment->owner;
+    size_t length = size * nmemb;
+
+    // Checked on every chunk so that not one byte of a full (200) or error
+    // body lands in the segment's range or gets committed to the sidecar.
+    if (segment->ranged ? segment->status != 206 : segment->status >= 400) {
+        return 0;
+    }
+
+    long long offset = segment->start + segment->written;
+    if (segment->end >= 0 && offset + (long long)length > segment->end + 1) {
+        length = segment->end + 1 - offset;
+    }
+
+    if (!owner->writer.write(segment->channel, ptr, length)) {
+        return 0;
+    }
+    segment->written += length;
+    TransferScheduler::instance().throttle(TransferLane::Bulk, length);
+
+    if (segment->ranged && owner->bytesWritten() - owner->committedBytes >= PART_COMMIT_INTERVAL) {
+        owner->commit(false);
+    }
+    return size * nmemb;
+}
+
+int SegmentedDownload::progressCallback(void* userdata, curl_off_t total, curl_off_t, curl_off_t, curl_off_t) {
+    Segment* segment = static_cast<Segment*>(userdata);
+    if (!segment->ranged) {
+        segment->streamTotal = total;
+    }
+    segment->owner->reportProgress(*segment);
+    return segment->owner->abortRequested ? 1 : 0;
+}
+
+long long SegmentedDownload::bytesWritten() const {
+    long long sum = 0;
+    for (const auto& segment : segments) {
+        sum += segment->written;
+    }
+    return sum;
+}
+
+void SegmentedDownload::reportProgress(const Segment& segment) {
+    long long total = segment.ranged ? probeInfo.contentLength : segment.streamTotal;
+    if (onProgress && !onProgress(bytesWritten(), total > 0 ? total : 0)) {
+        abortRequested = true;
+    }
+}
+
+bool SegmentedDownload::aborted() const {
+    return abortRequested;
+}
+
+uint32_t SegmentedDownload::checksum() const {
+    return fileCrc;
+}
+
+bool SegmentedDownload::fetchSegment(Segment& segment) {
+    for (int attempt = 0; attempt < SEGMENT_RETRIES && !abortRequested; attempt++) {
+        long long expected = segment.end >= 0 ? segment.end - segment.start + 1 : -1;
+        if (expected >= 0 && segment.written >= expected) {
+            return true;
+        }
+        if (!segment.ranged) {
+            // Without ranges a retry has to start over from the beginning.
+            segment.written = 0;
+            writer.seek(segment.channel, 0);
+        }
+
+        CURL* handle = http.acquire();
+        if (!handle) {
+            return false;
+        }
+
+        std::string range;
+        segment.status = 0;
+        curl.easy_setopt(handle, CURLOPT_URL, url.c_str());
+        curl.easy_setopt(handle, CURLOPT_HTTPHEADER, headerList);
+        if (segment.ranged) {
+            range = std::to_string(segment.start + segment.written) + "-" + std::to_string(segment.end);
+            curl.easy_setopt(handle, CURLOPT_RANGE, range.c_str());
+        }
+        curl.easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl.easy_setopt(handle, CURLOPT_WRITEDATA, &segment);
+        curl.easy_setopt(handle, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl.easy_setopt(handle, CURLOPT_HEADERDATA, &segment);
+        curl.easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, progressCallback);
+        curl.easy_setopt(handle, CURLOPT_XFERINFODATA, &segment);
+        curl.easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+
+        int res = curl.easy_perform(handle);
+        long code = responseCode(curl, handle);
+        TransferStats::instance().record(curl, handle, url, res);
+        http.release(handle);
+
+        if (abortRequested) {
+            return false;
+        }
+        if (segment.ranged && code == 200) {
+            std::cerr << "Server ignored range " << range << std::endl;
+            segment.rejected = true;
+            return false;
+        }
+        if (segment.ranged && code != 206) {
+            // No response, a server error or throttling: worth another try,
+            // and the data already on the card stays valid.
+            std::cerr << "Segment " << segment.start << "-" << segment.end << " got HTTP " << code << " ("
+                      << curl.easy_strerror(res) << "), retrying" << std::endl;
+            continue;
+        }
+        if (res == CURLE_OK && (expected < 0 || segment.written >= expected)) {
+            return true;
+        }
+        std::cerr << "Segment " << segment.start << "-" << segment.end << " interrupted: "
+                  << curl.easy_strerror(res) << ", retrying" << std::endl;
+    }
+    return false;
+}
+
+bool SegmentedDownload::runSegments(int segmentCount) {
+    std::vector<std::thread> workers;
+    std::vector<char> results(segmentCount, 0);
+    for (int i = 1; i < segmentCount; i++) {
+        workers.emplace_back([this, &results, i] { results[i] = fetchSegment(*segments[i]); });
+    }
+    results[0] = fetchSegment(*segments[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (int i = 0; i < segmentCount; i++) {
+        if (!results[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SegmentedDownload::loadPartState(const std::string& partPath) {
+    std::ifstream meta(partPath + ".meta");
+    if (!meta) {
+        return false;
+    }
+
+    std::string line;
+    std::string savedUrl, savedEtag, savedLastModified;
+    long long savedLength = -1;
+    std::vector<std::unique_ptr<Segment>> saved;
+    while (std::getline(meta, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+        if (key == "url") {
+            savedUrl = value;
+        } else if (key == "etag") {
+            savedEtag = value;
+        } else if (key == "lastModified") {
+            savedLastModified = value;
+        } else if (key == "length") {
+            savedLength = std::atoll(value.c_str());
+        } else if (key == "segment") {
+            auto segment = std::make_unique<Segment>();
+            long long written = 0;
+            unsigned int crc = 0;
+            if (sscanf(value.c_str(), "%lld %lld %lld %x", &segment->start, &segment->end, &written, &crc) != 4) {
+                return false;
+            }
+            segment->owner = this;
+            segment->ranged = true;
+            segment->written = written;
+            segment->crc = crc;
+            saved.push_back(std::move(segment));
+        }
+    }
+
+    // Only trust the partial data when a validator proves it is the same file.
+    bool sameFile = !probeInfo.etag.empty() ? probeInfo.etag == savedEtag
+                  : !probeInfo.lastModified.empty() && probeInfo.lastModified == savedLastModified;
+    struct stat st;
+    if (!sameFile || savedUrl != url || savedLength != probeInfo.contentLength || saved.empty() ||
+        stat(partPath.c_str(), &st) != 0 || st.st_size != savedLength) {
+        return false;
+    }
+
+    segments = std::move(saved);
+    return true;
+}
+
+void SegmentedDownload::commit(bool force) {
+    std::unique_lock<std::mutex> lock(commitMutex, std::defer_lock);
+    if (force) {
+        lock.lock();
+    } else if (!lock.try_lock() || bytesWritten() - committedBytes < PART_COMMIT_INTERVAL) {
+        // Another segment is already committing, or just did.
+        return;
+    }
+
+    // Snapshot what the write-behind thread has finished before syncing, so
+    // the sidecar never claims bytes that are still buffered or not on the
+    // card yet.
+    std::vector<long long> written;
+    std::vector<uint32_t> crcs;
+    for (const auto& segment : segments) {
+        uint32_t crc;
+        written.push_back(writer.durable(segment->channel, crc) - segment->start);
+        crcs.push_back(crc);
+    }
+    writer.sync();
+
+    std::string tmpPath = partPath + ".meta.tmp";
+    {
+        std::ofstream meta(tmpPath, std::ios::trunc);
+        meta << "url=" << url << "\n";
+        meta << "etag=" << probeInfo.etag << "\n";
+        meta << "lastModified=" << probeInfo.lastModified << "\n";
+        meta << "length=" << probeInfo.contentLength << "\n";
+        for (size_t i = 0; i < segments.size(); i++) {
+            char crc[9];
+            snprintf(crc, sizeof(crc), "%08x", crcs[i]);
+            meta << "segment=" << segments[i]->start << " " << segments[i]->end << " " << written[i] << " " << crc << "\n";
+        }
+    }
+    rename(tmpPath.c_str(), (partPath + ".meta").c_str());
+
+    long long total = 0;
+    for (long long n : written) {
+        total += n;
+    }
+    committedBytes = total;
+}
+
+int SegmentedDownload::run(const std::string& outputPath, int segmentCount, const ProgressCallback& progress) {
+    onProgress = progress;
+    partPath = outputPath + ".part";
+    segments.clear();
+    buildHeaderList();
+
+    long long length = probeInfo.contentLength;
+    bool ranged = probeInfo.acceptRanges && length > 0;
+    bool resumed = ranged && loadPartState(partPath);
+
+    // Preallocates the whole file, after checking that the rest of it fits.
+    if (!writer.open(partPath, length, !resumed)) {
+        std::cerr << "Failed to open file for writing: " << writer.error() << std::endl;
+        return -1;
+    }
+
+    if (resumed) {
+        std::cout << "Resuming " << partPath << " at " << bytesWritten() << " of " << length << " bytes" << std::endl;
+    }
+
+    // Small files are not worth the extra connections.
+    if (segmentCount < 1) {
+        segmentCount = 1;
+    }
+    if (length > 0 && length / MIN_SEGMENT_SIZE < segmentCount) {
+        segmentCount = length / MIN_SEGMENT_SIZE > 0 ? length / MIN_SEGMENT_SIZE : 1;
+    }
+
+    // A changed file answers with 200, which sends us down the fallback path.
+    // If-Range needs a strong validator, so a weak ETag falls back to the
+    // date, or to no If-Range at all.
+    std::string validator;
+    if (!probeInfo.etag.empty() && probeInfo.etag.compare(0, 2, "W/") != 0) {
+        validator = probeInfo.etag;
+    } else if (!probeInfo.lastModified.empty()) {
+        validator = probeInfo.lastModified;
+    }
+    if (ranged && !validator.empty()) {
+        headerList = curl.slist_append(headerList, ("If-Range: " + validator).c_str());
+    }
+
+    bool ok = false;
+    bool rejected = false;
+    if (ranged) {
+        if (!resumed) {
+            long long segmentSize = length / segmentCount;
+            for (int i = 0; i < segmentCount; i++) {
+                auto segment = std::make_unique<Segment>();
+                segment->owner = this;
+                segment->ranged = true;
+                segment->start = i * segmentSize;
+                segment->end = (i == segmentCount - 1) ? length - 1 : (i + 1) * segmentSize - 1;
+                segments.push_back(std::move(segment));
+            }
+        }
+        for (auto& segment : segments) {
+            segment->channel = writer.channel(segment->start + segment->written, segment->crc);
+        }
+        if (!resumed) {
+            commit();
+        }
+        std::cout << "Downloading in " << segments.size() << " segments" << std::endl;
+        ok = runSegments(segments.size());
+        for (const auto& segment : segments) {
+            rejected = rejected || segment->rejected;
+        }
+    }
+
+    if (!ok && (segments.empty() || rejected)) {
+        if (rejected) {
+            std::cout << "Falling back to a single stream" << std::endl;
+        }
+        // An unranged stream cannot be resumed, so it keeps no sidecar.
+        unlink((partPath + ".meta").c_str());
+        segments.clear();
+        writer.truncate(0);
+        auto segment = std::make_unique<Segment>();
+        segment->owner = this;
+        segment->channel = writer.channel(0);
+        segments.push_back(std::move(segment));
+        ok = fetchSegment(*segments[0]);
+        if (ok) {
+            ok = writer.truncate(segments[0]->written);
+        }
+    } else if (!ok) {
+        writer.flush();
+        commit();
+        std::cerr << "Download incomplete, kept " << partPath << " for resuming" << std::endl;
+    }
+
+    // Segments lie back to back in order, so their CRCs chain into the file's.
+    if (ok && writer.flush()) {
+        fileCrc = 0;
+        for (const auto& segment : segments) {
+            uint32_t crc;
+            long long end = writer.durable(segment->channel, crc);
+            fileCrc = crc32Combine(fileCrc, crc, end - segment->start);
+        }
+    }
+    if (!writer.close()) {
+        ok = false;
+    }
+
+    if (!ok) {
+        return -1;
+    }
+
+    unlink((partPath + ".meta").c_str());
+    if (rename(partPath.c_str(), outputPath.c_str()) != 0) {
+        std::cerr << "Failed to rename " << partPath << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "texture_cache.h"
+#include <SDL_image.h>
+#include <iostream>
+
+TextureCache::TextureCache(size_t budgetBytes)
+    : renderer(nullptr), budget(budgetBytes), used(0), hitCount(0), missCount(0) {}
+
+TextureCache::~TextureCache() {
+    clear();
+}
+
+void TextureCache::setRenderer(SDL_Renderer* target) {
+    clear();
+    renderer = target;
+}
+
+std::string TextureCache::keyFor(const std::string& path, int w, int h) {
+    return path + "@" + std::to_string(w) + "x" + std::to_string(h);
+}
+
+SDL_Texture* TextureCache::load(const std::string& path, int w, int h, size_t& bytes) {
+    SDL_Surface* image = IMG_Load(path.c_str());
+    if (!image) {
+        std::cerr << "IMG_Load Error: " << IMG_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // Scale once on the CPU so the texture only holds the pixels we draw.
+    SDL_Surface* source = image;
+    if (w > 0 && h > 0 && (image->w != w || image->h != h)) {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+        if (converted && scaled) {
+            SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+            SDL_BlitScaled(converted, nullptr, scaled, nullptr);
+            source = scaled;
+            scaled = nullptr;
+        }
+        if (converted) {
+            SDL_FreeSurface(converted);
+        }
+        if (scaled) {
+            SDL_FreeSurface(scaled);
+        }
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, source);
+    bytes = (size_t)source->w * source->h * 4;
+    if (source != image) {
+        SDL_FreeSurface(source);
+    }
+    SDL_FreeSurface(image);
+    if (!texture) {
+        std::cerr << "SDL_CreateTextureFromSurface Error: " << SDL_GetError() << std::endl;
+    }
+    return texture;
+}
+
+void TextureCache::add(const std::string& path, int w, int h, SDL_Texture* texture, size_t bytes) {
+    lru.push_front({keyFor(path, w, h), path, texture, bytes});
+    index[lru.front().key] = lru.begin();
+    used += bytes;
+    trim();
+}
+
+SDL_Texture* TextureCache::insert(const std::string& path, int w, int h) {
+    size_t bytes = 0;
+    SDL_Texture* texture = load(path, w, h, bytes);
+    if (!texture) {
+        return nullptr;
+    }
+    add(path, w, h, texture, bytes);
+    return texture;
+}
+
+SDL_Texture* TextureCache::get(const std::string& path, int w, int h) {
+    if (!renderer) {
+        return nullptr;
+    }
+    auto it = index.find(keyFor(path, w, h));
+    if (it != index.end()) {
+        hitCount++;
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->texture;
+    }
+    missCount++;
+    return insert(path, w, h);
+}
+
+bool TextureCache::preload(const std::string& path, int w, int h) {
+    if (!renderer) {
+        return false;
+    }
+    if (index.count(keyFor(path, w, h))) {
+        return true;
+    }
+    return insert(path, w, h) != nullptr;
+}
+
+SDL_Texture* TextureCache::find(const std::string& path, int w, int h) {
+    auto it = index.find(keyFor(path, w, h));
+    if (it == index.end()) {
+        return nullptr;
+    }
+    hitCount++;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->texture;
+}
+
+SDL_Texture* TextureCache::adopt(const std::string& path, int w, int h, SDL_Surface* surface) {
+    SDL_Texture* texture = renderer ? SDL_CreateTextureFromSurface(renderer, surface) : nullptr;
+    size_t bytes = (size_t)surface->w * surface->h * 4;
+    SDL_FreeSurface(surface);
+    if (!texture) {
+        std::cerr << "SDL_CreateTextureFromSurface Error: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    // A late duplicate replaces the older upload.
+    auto it = index.find(keyFor(path, w, h));
+    if (it != index.end()) {
+        SDL_DestroyTexture(it->second->texture);
+        used -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    add(path, w, h, texture, bytes);
+    return texture;
+}
+
+void TextureCache::evict(const std::string& path) {
+    for (auto it = lru.begin(); it != lru.end();) {
+        if (it->path == path) {
+            SDL_DestroyTexture(it->texture);
+            used -= it->bytes;
+            index.erase(it->key);
+            it = lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextureCache::clear() {
+    for (auto& entry : lru) {
+        SDL_DestroyTexture(entry.texture);
+    }
+    lru.clear();
+    index.clear();
+    used = 0;
+}
+
+void TextureCache::trim() {
+    // Never evict the entry that was just inserted, even if it alone is over budget.
+    while (used > budget && lru.size() > 1) {
+        Entry& oldest = lru.back();
+        SDL_DestroyTexture(oldest.texture);
+        used -= oldest.bytes;
+        index.erase(oldest.key);
+        lru.pop_back();
+    }
+}
+
+size_t TextureCache::hits() const {
+    return hitCount;
+}
+
+size_t TextureCache::misses() const {
+    return missCount;
+}
+
+size_t TextureCache::bytesUsed() const {
+    return used;
+}
@@ -1,7 +1,13 @@
 #include "theme.h"
 
+#include <cstring>
+
 Theme currentTheme;
+unsigned int themeGeneration = 0;
 
 void applyTheme(const Theme& theme) {
-    currentTheme = theme;
+    if (memcmp(&currentTheme, &theme, sizeof(Theme)) != 0) {
+        currentTheme = theme;
+        themeGeneration++;
+    }
 }
\ No newline at end of file
@@ -27,5 +27,5 @@ Theme ThemeManager::purpleTheme = {
 
 
 void ThemeManager::applyTheme(const Theme& theme) {
-    currentTheme = theme;
+    ::applyTheme(theme);
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "transfer_scheduler.h"
+#include "config.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+// A bucket holds at most this much of a second's worth of tokens, so an
+// idle lane cannot save up a burst, and may owe at most one second.
+static const double BURST_SECONDS = TRANSFER_BURST_MS / 1000.0;
+static const double MAX_DEBT_SECONDS = 1.0;
+static const double MAX_SLEEP_SECONDS = 0.1;
+
+void TransferScheduler::Bucket::setRate(long long bytesPerSecond, Clock::time_point now) {
+    rate = bytesPerSecond;
+    tokens = 0;
+    refilled = now;
+}
+
+void TransferScheduler::Bucket::refill(Clock::time_point now) {
+    if (rate <= 0) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - refilled).count();
+    tokens = std::min(tokens + elapsed * rate, rate * BURST_SECONDS);
+    refilled = now;
+}
+
+void TransferScheduler::Bucket::charge(size_t bytes) {
+    if (rate <= 0) {
+        return;
+    }
+    tokens = std::max(tokens - bytes, -rate * MAX_DEBT_SECONDS);
+}
+
+double TransferScheduler::Bucket::waitSeconds() const {
+    return rate > 0 && tokens < 0 ? -tokens / rate : 0;
+}
+
+TransferScheduler& TransferScheduler::instance() {
+    static TransferScheduler scheduler;
+    return scheduler;
+}
+
+TransferScheduler::TransferScheduler() : interactiveActive(0), bulkRate(0), bulkWindowBytes(0) {
+    Clock::time_point now = Clock::now();
+    interactive.setRate(TRANSFER_INTERACTIVE_LIMIT, now);
+    bulk.setRate(TRANSFER_BULK_LIMIT, now);
+    global.setRate(TRANSFER_GLOBAL_LIMIT, now);
+    yield.setRate(0, now);
+    bulkWindowStart = now;
+}
+
+TransferScheduler::Bucket& TransferScheduler::bucket(TransferLane lane) {
+    return lane == TransferLane::Interactive ? interactive : bulk;
+}
+
+void TransferScheduler::setLimit(TransferLane lane, long long bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bucket(lane).setRate(bytesPerSecond, Clock::now());
+}
+
+void TransferScheduler::setGlobalLimit(long long bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    global.setRate(bytesPerSecond, Clock::now());
+    std::cout << "Bandwidth cap: " << (bytesPerSecond > 0 ? std::to_string(bytesPerSecond / 1024) + " KB/s" : "none") << std::endl;
+}
+
+long long TransferScheduler::limit(TransferLane lane) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lane == TransferLane::Interactive ? interactive.rate : bulk.rate;
+}
+
+long long TransferScheduler::globalLimit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return global.rate;
+}
+
+void TransferScheduler::begin(TransferLane lane) {
+    if (lane != TransferLane::Interactive) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (interactiveActive++ == 0 && bulkRate > 0) {
+        // Measured before the interactive transfer started, so throttling
+        // bulk does not shrink its own allowance.
+        yield.setRate((long long)(bulkRate * INTERACTIVE_BULK_SHARE / 100), Clock::now());
+    }
+}
+
+void TransferScheduler::end(TransferLane lane) {
+    if (lane != TransferLane::Interactive) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--interactiveActive == 0) {
+        yield.setRate(0, Clock::now());
+    }
+}
+
+void TransferScheduler::measureBulk(size_t bytes, Clock::time_point now) {
+    if (interactiveActive > 0) {
+        return;
+    }
+    bulkWindowBytes += bytes;
+    double elapsed = std::chrono::duration<double>(now - bulkWindowStart).count();
+    if (elapsed >= 1.0) {
+        bulkRate = bulkRate > 0 ? (bulkRate + bulkWindowBytes / elapsed) / 2 : bulkWindowBytes / elapsed;
+        bulkWindowBytes = 0;
+        bulkWindowStart = now;
+    }
+}
+
+void TransferScheduler::throttle(TransferLane lane, size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Clock::time_point now = Clock::now();
+    Bucket& own = bucket(lane);
+    own.refill(now);
+    global.refill(now);
+    own.charge(bytes);
+    global.charge(bytes);
+    if (lane == TransferLane::Interactive) {
+        // Only its own lane holds an interactive transfer back.
+        while (own.waitSeconds() > 0) {
+            double wait = std::min(own.waitSeconds(), MAX_SLEEP_SECONDS);
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+            lock.lock();
+            own.refill(Clock::now());
+        }
+        return;
+    }
+
+    measureBulk(bytes, now);
+    bool sharing = global.rate <= 0 && yield.rate > 0;
+    if (sharing) {
+        yield.refill(now);
+        yield.charge(bytes);
+    }
+    // Sleep in slices so a limit raised meanwhile takes effect promptly.
+    for (;;) {
+        double wait = std::max(own.waitSeconds(), global.waitSeconds());
+        if (global.rate <= 0 && yield.rate > 0) {
+            wait = std::max(wait, yield.waitSeconds());
+        }
+        if (wait <= 0) {
+            return;
+        }
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(wait, MAX_SLEEP_SECONDS)));
+        lock.lock();
+        now = Clock::now();
+        own.refill(now);
+        global.refill(now);
+        yield.refill(now);
+    }
+}
@@ -0,0 +1,77 @@
+#include "transfer_stats.h"
+#include "config.h"
+#include <cstdio>
+#include <iostream>
+#include <sys/stat.h>
+
+TransferStats& TransferStats::instance() {
+    static TransferStats stats(CACHE_DIR "/transfers.log");
+    return stats;
+}
+
+TransferStats::TransferStats(const std::string& logPath)
+    : logPath(logPath), ring(TRANSFER_STATS_HISTORY), next(0), count(0) {
+    mkdir(CACHE_DIR, 0755);
+}
+
+void TransferStats::record(CurlApi& curl, CURL* handle, const std::string& url, int error) {
+    TransferRecord record;
+    record.url = url;
+    record.finished = time(nullptr);
+    record.error = error;
+    double bytes = 0;
+    curl.easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &record.status);
+    curl.easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME, &record.namelookup);
+    curl.easy_getinfo(handle, CURLINFO_CONNECT_TIME, &record.connect);
+    curl.easy_getinfo(handle, CURLINFO_APPCONNECT_TIME, &record.appconnect);
+    curl.easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &record.starttransfer);
+    curl.easy_getinfo(handle, CURLINFO_TOTAL_TIME, &record.total);
+    curl.easy_getinfo(handle, CURLINFO_SPEED_DOWNLOAD, &record.bytesPerSecond);
+    curl.easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD, &bytes);
+    record.bytes = (long long)bytes;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ring[next] = record;
+    next = (next + 1) % ring.size();
+    if (count < ring.size()) {
+        count++;
+    }
+    append(record);
+}
+
+void TransferStats::append(const TransferRecord& record) {
+    // Opened per record: transfers are seconds apart and the file stays
+    // complete if the device is switched off.
+    FILE* log = fopen(logPath.c_str(), "a");
+    if (!log) {
+        return;
+    }
+    fprintf(log, "%ld status=%ld error=%d dns=%.3f connect=%.3f tls=%.3f ttfb=%.3f total=%.3f bytes=%lld speed=%.0f %s\n",
+            (long)record.finished, record.status, record.error, record.namelookup, record.connect, record.appconnect,
+            record.starttransfer, record.total, record.bytes, record.bytesPerSecond, record.url.c_str());
+    fclose(log);
+}
+
+std::vector<TransferRecord> TransferStats::recent() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TransferRecord> records;
+    records.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        records.push_back(ring[(next + ring.size() - count + i) % ring.size()]);
+    }
+    return records;
+}
+
+double TransferStats::averageTimeToFirstByte() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    double sum = 0;
+    size_t samples = 0;
+    for (size_t i = 0; i < count; i++) {
+        const TransferRecord& record = ring[(next + ring.size() - 1 - i) % ring.size()];
+        if (record.error == 0 && record.starttransfer > 0) {
+            sum += record.starttransfer;
+            samples++;
+        }
+    }
+    return samples > 0 ? sum / samples : 0;
+}
@@ -1,6 +1,9 @@
 #include "ui_manager.h"
+#include "config.h"
+#include "output_writer.h"
+#include <cstdio>
 
-UIManager::UIManager(Renderer& renderer) : renderer(renderer) {}
+UIManager::UIManager(Renderer& renderer) : renderer(renderer), consoleView(renderer), filterView(renderer), gameView(renderer), shownView(nullptr) {}
 
 UIManager::~UIManager() {
 
@@ -8,90 +11,188 @@ UIManager::~UIManager() {
 }
 
 void UIManager::drawConsoleList(const std::vector<Console>& consoles, int selectedConsole, int scrollOffset) {
-    const int maxItemsPerPage = 40;
-    const int itemsPerRow = 20;
-    const int columnWidth = 250;
-    const int rowHeight = 30;
-    const int offset = 10;
+    shownView = &consoleView;
+    consoleView.draw(consoles.size(), [&consoles](size_t i) { return std::string_view(consoles[i].name); }, selectedConsole, scrollOffset);
+}
+
+void UIManager::drawFilterList(const std::vector<Filter>& filters, int selectedFilter, int scrollOffset) {
+    shownView = &filterView;
+    filterView.draw(filters.size(), [&filters](size_t i) { return std::string_view(filters[i].value); }, selectedFilter, scrollOffset);
+}
+
+void UIManager::drawGameList(const GameList& games, int selectedGame, int scrollOffset) {
+    shownView = &gameView;
+    gameView.draw(games.size(), [&games](size_t i) { return games.title(i); }, selectedGame, scrollOffset);
+}
+
+void UIManager::drawGameList(const CatalogIndex::Slice& games, int selectedGame, int scrollOffset) {
+    shownView = &gameView;
+    gameView.draw(games.size(), [&games](size_t i) { return games.title(i); }, selectedGame, scrollOffset);
+}
+
+static std::string formatRate(double bytesPerSecond) {
+    char buffer[32];
+    if (bytesPerSecond >= 1024 * 1024) {
+        snprintf(buffer, sizeof(buffer), "%.1f MB/s", bytesPerSecond / (1024 * 1024));
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.0f KB/s", bytesPerSecond / 1024);
+    }
+    return buffer;
+}
 
-    int currentPage = selectedConsole / maxItemsPerPage;
+// True when the list drawn last has a selected label wider than its slot.
+bool UIManager::marqueeScrolls() const {
+    return shownView && shownView->scrolling();
+}
 
-    for (size_t i = currentPage * maxItemsPerPage; i < consoles.size() && i < (currentPage + 1) * maxItemsPerPage; i++) {
-        SDL_Color color = currentTheme.textColor;
-        std::string displayText = shortenText(consoles[i].name, 20);
-        if (i == selectedConsole) {
-            color = currentTheme.highlightColor;
-            displayText = scrollText(consoles[i].name, scrollOffset);
+int UIManager::drawDownloads(const std::vector<DownloadItem>& items, int firstRow) {
+    // One bar per running transfer, with the next queued title above them.
+    int row = firstRow;
+    const DownloadItem* next = nullptr;
+    int queued = 0;
+    for (const auto& item : items) {
+        if (item.state == DownloadState::Queued) {
+            if (!next) {
+                next = &item;
+            }
+            queued++;
+            continue;
+        }
+        if (item.state == DownloadState::Done || item.state == DownloadState::Failed) {
+            continue;
         }
-        int column = (i % maxItemsPerPage) / itemsPerRow;
-        int row = (i % maxItemsPerPage) % itemsPerRow;
-        renderer.drawText(displayText, offset + 40 + column * columnWidth, offset + 40 + row * rowHeight, color);
+        int progress = item.bytesTotal > 0 ? (int)(item.bytesDone * 100 / item.bytesTotal) : 0;
+        std::string label = shortenText(item.title, 24) + "  ";
+        if (item.state == DownloadState::Downloading) {
+            label += std::to_string(progress) + "%  " + formatRate(item.bytesPerSecond);
+        } else {
+            label += downloadStateName(item.state);
+        }
+        renderer.drawProgressBar(progress, label, row++);
+    }
+    if (next) {
+        std::string text = "Next: " + shortenText(next->title, 24);
+        if (queued > 1) {
+            text += " (+" + std::to_string(queued - 1) + ")";
+        }
+        renderer.drawText(text, SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 90 - row * 70, currentTheme.textColor);
+        row++;
     }
+    return row;
 }
 
-void UIManager::drawFilterList(const std::vector<Filter>& filters, int selectedFilter, int scrollOffset) {
-    const int maxItemsPerPage = 40;
-    const int itemsPerRow = 20;
-    const int columnWidth = 250;
-    const int rowHeight = 30;
-    const int offset = 10;
+int UIManager::drawExtractions(const std::vector<ExtractJob>& jobs, int firstRow) {
+    int row = firstRow;
+    int queued = 0;
+    for (const auto& job : jobs) {
+        if (job.state == ExtractState::Queued) {
+            queued++;
+        } else if (job.state == ExtractState::Running) {
+            std::string name = job.archive.substr(job.archive.find_last_of('/') + 1);
+            renderer.drawProgressBar(job.percent, "Extracting " + shortenText(name, 20) + "  " + std::to_string(job.percent) + "%", row++);
+        }
+    }
+    if (queued > 0) {
+        renderer.drawText(std::to_string(queued) + " archives waiting to extract", SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 90 - row * 70, currentTheme.textColor);
+        row++;
+    }
+    return row;
+}
 
-    int currentPage = selectedFilter / maxItemsPerPage;
+int UIManager::drawBandwidthCap(long long bytesPerSecond, int firstRow) {
+    if (bytesPerSecond <= 0) {
+        return firstRow;
+    }
+    renderer.drawText("Bandwidth cap: " + formatRate(bytesPerSecond), SCREEN_WIDTH / 2 + 10 + 70, SCREEN_HEIGHT - 10 - 90 - firstRow * 70, currentTheme.textColor);
+    return firstRow + 1;
+}
 
-    for (size_t i = currentPage * maxItemsPerPage; i < filters.size() && i < (currentPage + 1) * maxItemsPerPage; i++) {
-        SDL_Color color = currentTheme.textColor;
-        std::string displayText = shortenText(filters[i].value, 20);
-        if (i == selectedFilter) {
-            color = currentTheme.highlightColor;
-            displayText = scrollText(filters[i].value, scrollOffset);
+void UIManager::drawStatsOverlay(const std::vector<DownloadItem>& items, double averageTtfb, double frameMs) {
+    double speed = 0;
+    long long remaining = 0;
+    bool sizeKnown = true;
+    for (const auto& item : items) {
+        if (item.state != DownloadState::Downloading) {
+            continue;
+        }
+        speed += item.bytesPerSecond;
+        if (item.bytesTotal > 0) {
+            remaining += item.bytesTotal - item.bytesDone;
+        } else {
+            sizeKnown = false;
         }
-        int column = (i % maxItemsPerPage) / itemsPerRow;
-        int row = (i % maxItemsPerPage) % itemsPerRow;
-        renderer.drawText(displayText, offset + 40 + column * columnWidth, offset + 40 + row * rowHeight, color);
     }
+
+    std::vector<std::string> lines;
+    lines.push_back("Speed: " + formatRate(speed));
+    if (speed > 0 && sizeKnown) {
+        long long seconds = (long long)(remaining / speed);
+        char eta[32];
+        snprintf(eta, sizeof(eta), "ETA: %lld:%02lld", seconds / 60, seconds % 60);
+        lines.push_back(eta);
+    } else {
+        lines.push_back("ETA: --");
+    }
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "Avg TTFB: %.0f ms", averageTtfb * 1000);
+    lines.push_back(buffer);
+    snprintf(buffer, sizeof(buffer), "Frame: %.1f ms", frameMs);
+    lines.push_back(buffer);
+    OutputWriter::Stats disk = OutputWriter::totals();
+    if (disk.flushes > 0) {
+        snprintf(buffer, sizeof(buffer), "Disk flush: %.1f ms avg, %.0f ms max", disk.flushMsTotal / disk.flushes, disk.flushMsMax);
+        lines.push_back(buffer);
+    }
+    renderer.drawOverlay(lines);
 }
 
-void UIManager::drawGameList(const std::vector<Game>& games, int selectedGame, int scrollOffset) {
-    const int maxItemsPerPage = 40;
-    const int itemsPerRow = 20;
-    const int columnWidth = 250;
-    const int rowHeight = 30;
+void UIManager::drawLoadingIndicator(size_t rowsLoaded, int tick) {
     const int offset = 10;
+    std::string text = "Loading" + std::string(tick % 4, '.');
+    if (rowsLoaded > 0) {
+        text += " (" + std::to_string(rowsLoaded) + " games)";
+    }
+    renderer.drawText(text, offset + 40, SCREEN_HEIGHT - offset - 60, currentTheme.highlightColor);
+}
 
-    int currentPage = selectedGame / maxItemsPerPage;
+void UIManager::drawSearch(const OnScreenKeyboard& keyboard, const std::string& scope, size_t resultCount, bool keyboardFocused) {
+    const int left = SCREEN_WIDTH / 2 + 10 + 40;
+    const int top = 10 + 40;
+    const int keyWidth = 52;
+    const int rowHeight = 50;
 
-    for (size_t i = currentPage * maxItemsPerPage; i < games.size() && i < (currentPage + 1) * maxItemsPerPage; i++) {
-        SDL_Color color = currentTheme.textColor;
-        std::string displayText = shortenText(games[i].title, 20);
-        if (i == selectedGame) {
-            color = currentTheme.highlightColor;
-            displayText = scrollText(games[i].title, scrollOffset);
+    renderer.drawText("Search " + scope, left, top, currentTheme.textColor);
+    renderer.drawText(keyboard.text() + "_", left, top + 40, currentTheme.highlightColor);
+    std::string count = keyboard.text().empty() ? "Type to search" : std::to_string(resultCount) + " matches";
+    renderer.drawText(count, left, top + 80, currentTheme.textColor);
+
+    const std::vector<std::string>& rows = keyboard.rows();
+    for (int r = 0; r < (int)rows.size(); r++) {
+        // The bottom row holds the wide keys.
+        int width = r + 1 == (int)rows.size() ? keyWidth * 3 : keyWidth;
+        for (int c = 0; c < (int)rows[r].size(); c++) {
+            char key = rows[r][c];
+            std::string label(1, key);
+            if (key == OnScreenKeyboard::SPACE_KEY) {
+                label = "SPACE";
+            } else if (key == OnScreenKeyboard::DELETE_KEY) {
+                label = "DEL";
+            } else if (key == OnScreenKeyboard::DONE_KEY) {
+                label = "OK";
+            }
+            bool selected = keyboardFocused && r == keyboard.row() && c == keyboard.column();
+            SDL_Color color = selected ? currentTheme.highlightColor : currentTheme.textColor;
+            if (selected) {
+                label = "[" + label + "]";
+            }
+            renderer.drawText(label, left + c * width, top + 140 + r * rowHeight, color);
         }
-        int column = (i % maxItemsPerPage) / itemsPerRow;
-        int row = (i % maxItemsPerPage) % itemsPerRow;
-        renderer.drawText(displayText, offset + 40 + column * columnWidth, offset + 40 + row * rowHeight, color);
     }
 }
 
-void UIManager::drawProgressBar(int progress, const std::string& title, const std::vector<std::string>& queuedTitles) {
-    renderer.drawProgressBar(progress, title, queuedTitles);
-}
-
 std::string UIManager::shortenText(const std::string& text, int maxLength) {
     if (text.length() > maxLength) {
         return text.substr(0, maxLength - 3) + "...";
     }
     return text;
 }
-
-std::string UIManager::scrollText(const std::string& text, int offset) {
-    std::string spacedText;
-    if (text.length() >= 2) {
-        spacedText = text + "      ";
-    } else {
-        spacedText = text + " ";
-    }
-    int length = spacedText.length();
-    std::string scrolledText = spacedText.substr(offset % length) + spacedText.substr(0, offset % length);
-    return scrolledText.substr(0, 32);
-}
\ No newline at end of file
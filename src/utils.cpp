@@ -1,6 +1,19 @@
 #include "utils.h"
 #include "types.h"
+#include "config.h"
+#include "http_client.h"
+#include "http_cache.h"
+#include "segmented_download.h"
+#include "zip_stream.h"
+#include "output_writer.h"
+#include "extraction_queue.h"
+#include "crc32.h"
 #include <atomic>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+#include <unistd.h>
+#include <unordered_set>
 
 std::unordered_map<std::string, std::string> systemToRomFolder = {
     {"Atari 2600", "ATARI2600"},
@@ -28,23 +41,19 @@ std::unordered_map<std::string, std::string> systemToRomFolder = {
 };
 
 
-typedef void* CURL;
-typedef CURL* (*curl_easy_init_t)();
-typedef void (*curl_easy_cleanup_t)(CURL*);
-typedef int (*curl_easy_setopt_t)(CURL*, int, ...);
-typedef int (*curl_easy_perform_t)(CURL*);
-typedef const char* (*curl_easy_strerror_t)(int);
-typedef struct curl_slist* (*curl_slist_append_t)(struct curl_slist*, const char*);
+std::atomic<int> downloadSegments(DOWNLOAD_SEGMENTS);
 
-// curl_off_t
-typedef long long curl_off_t;
+void setDownloadSegments(int segments) {
+    downloadSegments = segments > 0 ? segments : 1;
+}
 
+// Folders whose games are unpacked after download, as the SELECT action did for PS/PSP.
+std::unordered_set<std::string> extractFolders = {"PS", "PSP", "SEGACD", "PCECD", "SATURN", "DC"};
 
-int progressCallback(void* ptr, curl_off_t total, curl_off_t now, curl_off_t, curl_off_t) {
-    if (total > 0) {
-        downloadProgress = static_cast<int>((now * 100) / total);
-    }
-    return 0;
+std::atomic<bool> keepArchives(KEEP_ARCHIVES);
+
+void setKeepArchives(bool keep) {
+    keepArchives = keep;
 }
 
 
@@ -62,50 +71,52 @@ size_t header_callback(void* ptr, size_t size, size_t nmemb, std::string* filena
     return size * nmemb;
 }
 
-std::string getHtml(const std::string& url) {
-    void* handle = dlopen("/usr/lib/libcurl.so.4", RTLD_LAZY);
-    if (!handle) {
-        std::cerr << "Failed to load libcurl: " << dlerror() << std::endl;
-        return "1";
-    }
-
-    auto curl_easy_init = (curl_easy_init_t)dlsym(handle, "curl_easy_init");
-    auto curl_easy_cleanup = (curl_easy_cleanup_t)dlsym(handle, "curl_easy_cleanup");
-    auto curl_easy_setopt = (curl_easy_setopt_t)dlsym(handle, "curl_easy_setopt");
-    auto curl_easy_perform = (curl_easy_perform_t)dlsym(handle, "curl_easy_perform");
-
-    if (!curl_easy_init || !curl_easy_cleanup || !curl_easy_setopt || !curl_easy_perform) {
-        std::cerr << "Failed to resolve libcurl functions." << std::endl;
-        dlclose(handle);
-        return "1";
-    }
-
-    CURL* curl = curl_easy_init();
-    std::string html;
-    if (curl) {
-        curl_easy_setopt(curl, 10002 /* CURLOPT_URL */, url.c_str());
-        curl_easy_setopt(curl, 64 /* CURLOPT_SSL_VERIFYPEER */, 0L); // Disable SSL verification
-        curl_easy_setopt(curl, 81 /* CURLOPT_SSL_VERIFYHOST */, 0L); // Disable host verification
-        curl_easy_setopt(curl, 10001 /* CURLOPT_WRITEDATA */, &html);
-        curl_easy_setopt(curl, 20011 /* CURLOPT_WRITEFUNCTION */, +[](char* ptr, size_t size, size_t nmemb, std::string* data) {
-            data->append(ptr, size * nmemb);
-            return size * nmemb;
-        });
-        int res = curl_easy_perform(curl);
-        if (res != 0) {
-            std::cerr << "curl_easy_perform failed with error code: " << res << std::endl;
-        }
-        curl_easy_cleanup(curl);
-        dlclose(handle);
+ResponseBuffer getHtml(const std::string& url) {
+    HttpClient& http = HttpClient::instance();
+    if (!http.available()) {
+        ResponseBuffer placeholder;
+        placeholder.append("1", 1);
+        return placeholder;
+    }
+
+    HttpResponse response = http.get(url);
+    if (response.error != 0) {
+        std::cerr << "curl_easy_perform failed with error code: " << response.error << std::endl;
     }
+    return std::move(response.body);
+}
 
-    return html;
+// Catalog pages change rarely, so they are served from the on-card cache
+// and refreshed in the background.
+ResponseBody getCatalogHtml(const std::string& url) {
+    return HttpCache::instance().fetch(url);
 }
 
-std::vector<Console> parseHTML(const std::string& html) {
+// Parses a body where it lies: a single block directly, a segmented one by
+// pushing its segments through the parser instead of joining them first.
+htmlDocPtr readHtml(const ResponseBuffer& html) {
+    const int options = HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING;
+    if (html.contiguous()) {
+        return htmlReadMemory(html.data(), html.size(), nullptr, nullptr, options);
+    }
+    htmlParserCtxtPtr ctxt = htmlCreatePushParserCtxt(nullptr, nullptr, nullptr, 0, nullptr, XML_CHAR_ENCODING_NONE);
+    if (!ctxt) {
+        return nullptr;
+    }
+    htmlCtxtUseOptions(ctxt, options);
+    for (size_t i = 0; i < html.segmentCount(); i++) {
+        htmlParseChunk(ctxt, html.segmentData(i), html.segmentSize(i), 0);
+    }
+    htmlParseChunk(ctxt, nullptr, 0, 1);
+    htmlDocPtr doc = ctxt->myDoc;
+    htmlFreeParserCtxt(ctxt);
+    return doc;
+}
+
+std::vector<Console> parseHTML(const ResponseBuffer& html) {
     std::vector<Console> consoles;
 
-    htmlDocPtr doc = htmlReadMemory(html.c_str(), html.size(), NULL, NULL, HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
+    htmlDocPtr doc = readHtml(html);
     if (doc == NULL) {
         std::cerr << "Failed to parse HTML" << std::endl;
         return consoles;
@@ -151,10 +162,36 @@ std::vector<Console> parseHTML(const std::string& html) {
     return consoles;
 }
 
-std::vector<Game> parseGamesHTML(const std::string &htmlContent) {
-    std::vector<Game> games;
+// libxml2 hands out copies that the caller has to free.
+static std::string nodeText(xmlNodePtr node) {
+    xmlChar* content = xmlNodeGetContent(node);
+    std::string text = content ? reinterpret_cast<const char*>(content) : "";
+    xmlFree(content);
+    return text;
+}
+
+static std::string nodeProperty(xmlNodePtr node, const char* name) {
+    xmlChar* value = xmlGetProp(node, reinterpret_cast<const xmlChar*>(name));
+    std::string text = value ? reinterpret_cast<const char*>(value) : "";
+    xmlFree(value);
+    return text;
+}
+
+static bool isElement(xmlNodePtr node, const char* name) {
+    return node && node->type == XML_ELEMENT_NODE && xmlStrEqual(node->name, reinterpret_cast<const xmlChar*>(name));
+}
+
+static xmlNodePtr firstElement(xmlNodePtr node) {
+    while (node && node->type != XML_ELEMENT_NODE) {
+        node = node->next;
+    }
+    return node;
+}
+
+GameList parseGamesHTML(const ResponseBuffer& htmlContent) {
+    GameList games;
 
-    htmlDocPtr doc = htmlReadMemory(htmlContent.c_str(), htmlContent.size(), nullptr, nullptr, HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
+    htmlDocPtr doc = readHtml(htmlContent);
     if (!doc) {
         std::cerr << "Error: unable to parse HTML document\n";
         return games;
@@ -175,57 +212,45 @@ std::vector<Game> parseGamesHTML(const std::string &htmlContent) {
         return games;
     }
 
-    for (int i = 0; i < result->nodesetval->nodeNr; ++i) {
+    // The page text is a generous upper bound for the titles and URLs.
+    games.reserve(result->nodesetval ? result->nodesetval->nodeNr : 0, htmlContent.size() / 8);
+    Game game;
+    for (int i = 0; result->nodesetval && i < result->nodesetval->nodeNr; ++i) {
         xmlNodePtr row = result->nodesetval->nodeTab[i];
-        Game game;
-
-        xmlNodePtr titleNode = row->children;
-        while (titleNode && titleNode->type != XML_ELEMENT_NODE) {
-            titleNode = titleNode->next;
+        game.title.clear();
+        game.region.clear();
+        game.version.clear();
+        game.languages.clear();
+        game.rating.clear();
+        game.url.clear();
+
+        // Cells in order: title, region, version, languages, rating.
+        xmlNodePtr cells[5] = {};
+        xmlNodePtr cell = firstElement(row->children);
+        for (int c = 0; c < 5 && isElement(cell, "td"); c++) {
+            cells[c] = cell;
+            cell = firstElement(cell->next);
         }
 
-        if (titleNode && xmlStrEqual(titleNode->name, reinterpret_cast<const xmlChar*>("td"))) {
-            xmlNodePtr aNode = titleNode->children;
-            while (aNode && aNode->type != XML_ELEMENT_NODE) {
-                aNode = aNode->next;
-            }
-            if (aNode && xmlStrEqual(aNode->name, reinterpret_cast<const xmlChar*>("a"))) {
-                game.title = reinterpret_cast<const char*>(xmlNodeGetContent(aNode));
-                xmlChar* href = xmlGetProp(aNode, reinterpret_cast<const xmlChar*>("href"));
-                if (href) {
-                    game.url = reinterpret_cast<const char*>(href);
-                    xmlFree(href);
-                }
-            }
+        xmlNodePtr link = cells[0] ? firstElement(cells[0]->children) : nullptr;
+        if (isElement(link, "a")) {
+            game.title = nodeText(link);
+            game.url = nodeProperty(link, "href");
         }
-
-        xmlNodePtr regionNode = titleNode->next;
-        if (regionNode && regionNode->type == XML_ELEMENT_NODE && xmlStrEqual(regionNode->name, reinterpret_cast<const xmlChar*>("td"))) {
-            xmlNodePtr imgNode = regionNode->children;
-            if (imgNode && imgNode->type == XML_ELEMENT_NODE && xmlStrEqual(imgNode->name, reinterpret_cast<const xmlChar*>("img"))) {
-                game.region = reinterpret_cast<const char*>(xmlGetProp(imgNode, reinterpret_cast<const xmlChar*>("title")));
-            }
+        if (cells[1] && isElement(cells[1]->children, "img")) {
+            game.region = nodeProperty(cells[1]->children, "title");
         }
-
-        xmlNodePtr versionNode = regionNode->next;
-        if (versionNode && versionNode->type == XML_ELEMENT_NODE && xmlStrEqual(versionNode->name, reinterpret_cast<const xmlChar*>("td"))) {
-            game.version = reinterpret_cast<const char*>(xmlNodeGetContent(versionNode));
+        if (cells[2]) {
+            game.version = nodeText(cells[2]);
         }
-
-        xmlNodePtr languagesNode = versionNode->next;
-        if (languagesNode && languagesNode->type == XML_ELEMENT_NODE && xmlStrEqual(languagesNode->name, reinterpret_cast<const xmlChar*>("td"))) {
-            game.languages = reinterpret_cast<const char*>(xmlNodeGetContent(languagesNode));
+        if (cells[3]) {
+            game.languages = nodeText(cells[3]);
         }
-
-        xmlNodePtr ratingNode = languagesNode->next;
-        if (ratingNode && ratingNode->type == XML_ELEMENT_NODE && xmlStrEqual(ratingNode->name, reinterpret_cast<const xmlChar*>("td"))) {
-            xmlNodePtr aNode = ratingNode->children;
-            if (aNode && aNode->type == XML_ELEMENT_NODE && xmlStrEqual(aNode->name, reinterpret_cast<const xmlChar*>("a"))) {
-                game.rating = reinterpret_cast<const char*>(xmlNodeGetContent(aNode));
-            }
+        if (cells[4] && isElement(cells[4]->children, "a")) {
+            game.rating = nodeText(cells[4]->children);
         }
 
-        games.push_back(game);
+        games.add(game);
     }
 
     xmlXPathFreeObject(result);
@@ -237,21 +262,193 @@ std::vector<Game> parseGamesHTML(const std::string &htmlContent) {
 
 
 
-int downloadGame(std::string console, const std::string &htmlContent) {
-    xmlInitParser();
-    LIBXML_TEST_VERSION
+// Byte ranges apply to the raw payload, so no Accept-Encoding is requested here.
+static std::vector<std::string> downloadHeaders() {
+    return {
+        "Host: download2.vimm.net",
+        "Sec-Ch-Ua: \"Not;A=Brand\";v=\"24\", \"Chromium\";v=\"128\"",
+        "Sec-Ch-Ua-Mobile: ?0",
+        "Sec-Ch-Ua-Platform: \"Windows\"",
+        "Accept-Language: en-GB,en;q=0.9",
+        "Upgrade-Insecure-Requests: 1",
+        "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/128.0.6613.120 Safari/537.36",
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7",
+        "Sec-Fetch-Site: same-site",
+        "Sec-Fetch-Mode: navigate",
+        "Sec-Fetch-User: ?1",
+        "Sec-Fetch-Dest: document",
+        "Referer: https://vimm.net/vault/40297",
+        "Priority: u=0, i",
+        "Connection: keep-alive"
+    };
+}
+
+static bool hasExtension(const std::string& name, const std::string& extension) {
+    if (name.size() < extension.size()) {
+        return false;
+    }
+    return strcasecmp(name.c_str() + name.size() - extension.size(), extension.c_str()) == 0;
+}
+
+static std::string shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+}
+
+static int extract7z(const std::string& archivePath, const std::string& romPath) {
+    std::string command = "/mnt/SDCARD/System/bin/7zz x " + shellQuote(archivePath) + " -o" + shellQuote(romPath) + " -y";
+    int res = system(command.c_str());
+    if (res != 0) {
+        std::cerr << "Failed to extract " << archivePath << " (status " << res << ")" << std::endl;
+        return -1;
+    }
+    std::cout << "Extracted " << archivePath << std::endl;
+    return 0;
+}
+
+static std::string readChecksum(xmlXPathContextPtr xpathCtx, const std::string& id, const std::string& label) {
+    // The hash cell is either tagged with an id or follows a label cell.
+    std::string expressions[] = {
+        "//*[@id='" + id + "']",
+        "//td[normalize-space(translate(., ':', ''))='" + label + "']/following-sibling::td[1]"
+    };
+    for (const auto& expression : expressions) {
+        xmlXPathObjectPtr result = xmlXPathEvalExpression((const xmlChar*)expression.c_str(), xpathCtx);
+        std::string value;
+        if (result && result->nodesetval && result->nodesetval->nodeNr > 0) {
+            xmlChar* content = xmlNodeGetContent(result->nodesetval->nodeTab[0]);
+            if (content) {
+                for (const char* p = (const char*)content; *p; p++) {
+                    if (isxdigit((unsigned char)*p)) {
+                        value += tolower((unsigned char)*p);
+                    }
+                }
+                xmlFree(content);
+            }
+        }
+        if (result) {
+            xmlXPathFreeObject(result);
+        }
+        if (!value.empty()) {
+            return value;
+        }
+    }
+    return "";
+}
 
-    htmlDocPtr doc = htmlReadMemory(htmlContent.c_str(), htmlContent.size(), nullptr, nullptr, HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
+MediaChecksums parseChecksums(const ResponseBuffer& htmlContent) {
+    MediaChecksums checksums;
+    htmlDocPtr doc = readHtml(htmlContent);
     if (doc == nullptr) {
-        std::cerr << "Failed to parse HTML" << std::endl;
+        return checksums;
+    }
+    xmlXPathContextPtr xpathCtx = xmlXPathNewContext(doc);
+    if (xpathCtx != nullptr) {
+        checksums.crc32 = readChecksum(xpathCtx, "data-crc", "CRC");
+        xmlXPathFreeContext(xpathCtx);
+    }
+    xmlFreeDoc(doc);
+    if (checksums.crc32.size() != 8) {
+        checksums.crc32.clear();
+    }
+    return checksums;
+}
+
+// Compares the CRC-32 worked out while a download was written with the
+// published one.
+static bool matchesPublishedCrc(uint32_t crc, const MediaChecksums& checksums) {
+    if (checksums.crc32.empty()) {
+        return true;
+    }
+    char actual[9];
+    snprintf(actual, sizeof(actual), "%08x", crc);
+    if (checksums.crc32 != actual) {
+        std::cerr << "Checksum mismatch: expected CRC " << checksums.crc32 << ", got " << actual << std::endl;
+        return false;
+    }
+    std::cout << "Verified CRC " << checksums.crc32 << " (" << crc32Implementation() << ")" << std::endl;
+    return true;
+}
+
+// Downloads a zip in one in-order stream. Every entry's CRC-32 is checked as
+// it inflates, and the archive's own CRC against the published one; a
+// mismatch fails the attempt so the caller retries. Entries are unpacked into romPath
+// when it is set, and the archive is only written when archivePath is set.
+// There is nothing to resume from, so a failed attempt removes its output.
+static int streamZip(HttpClient& http, const std::string& url, long long contentLength, const std::string& romPath,
+                     const std::string& archivePath, const MediaChecksums& checksums, const ProgressCallback& onProgress, bool& aborted) {
+    ZipStream zip(romPath);
+    std::string spaceError;
+    // The unpacked entries are at least as large as the archive.
+    if (!romPath.empty() && !OutputWriter::checkFreeSpace(romPath + "/", contentLength, spaceError)) {
+        std::cerr << spaceError << std::endl;
+        return -1;
+    }
+    OutputWriter archive;
+    int channel = -1;
+    if (!archivePath.empty()) {
+        if (!archive.open(archivePath + ".part", contentLength, true)) {
+            std::cerr << "Failed to open file for writing: " << archive.error() << std::endl;
+            return -1;
+        }
+        channel = archive.channel(0);
+    }
+
+    if (!romPath.empty()) {
+        std::cout << "Extracting while downloading into " << romPath << std::endl;
+    }
+    long long received = 0;
+    uint32_t crc = 0;
+    HttpResponse response = http.stream(url, [&](const char* data, size_t size) {
+        if (!zip.feed(data, size)) {
+            return false;
+        }
+        crc = crc32Update(crc, data, size);
+        if (channel >= 0 && !archive.write(channel, data, size)) {
+            return false;
+        }
+        received += size;
+        if (onProgress && !onProgress(received, contentLength > 0 ? contentLength : 0)) {
+            aborted = true;
+            return false;
+        }
+        return true;
+    }, downloadHeaders(), TransferLane::Bulk);
+
+    bool ok = response.error == CURLE_OK && response.status == 200 && zip.finish() && matchesPublishedCrc(crc, checksums);
+    if (channel >= 0) {
+        ok = archive.truncate(received) && archive.close() && ok;
+        if (ok) {
+            rename((archivePath + ".part").c_str(), archivePath.c_str());
+        } else {
+            unlink((archivePath + ".part").c_str());
+        }
+    }
+    if (!ok) {
+        zip.discard();
         return -1;
     }
+    if (!romPath.empty()) {
+        std::cout << "Extracted " << zip.files().size() << " files" << std::endl;
+    }
+    return 0;
+}
+
+std::string parseMediaId(const ResponseBuffer& htmlContent) {
+    htmlDocPtr doc = readHtml(htmlContent);
+    if (doc == nullptr) {
+        std::cerr << "Failed to parse HTML" << std::endl;
+        return "";
+    }
 
     xmlXPathContextPtr xpathCtx = xmlXPathNewContext(doc);
     if (xpathCtx == nullptr) {
         std::cerr << "Failed to create XPath context" << std::endl;
         xmlFreeDoc(doc);
-        return -1;
+        return "";
     }
 
     xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression((const xmlChar*)"//form[@id='dl_form']/input[@name='mediaId']", xpathCtx);
@@ -259,7 +456,7 @@ int downloadGame(std::string console, const std::string &htmlContent) {
         std::cerr << "Failed to evaluate XPath expression" << std::endl;
         xmlXPathFreeContext(xpathCtx);
         xmlFreeDoc(doc);
-        return -1;
+        return "";
     }
 
     std::string mediaId;
@@ -275,10 +472,20 @@ int downloadGame(std::string console, const std::string &htmlContent) {
     xmlXPathFreeObject(xpathObj);
     xmlXPathFreeContext(xpathCtx);
     xmlFreeDoc(doc);
-    xmlCleanupParser();
+    return mediaId;
+}
+
+int downloadGame(std::string console, const ResponseBuffer& htmlContent, const ProgressCallback& onProgress, const std::function<void()>& onExtracting,
+                 ExtractionQueue* extractionQueue) {
+    std::string mediaId = parseMediaId(htmlContent);
 
     std::cout << "Extracted mediaId: " << mediaId << std::endl;
 
+    MediaChecksums checksums = parseChecksums(htmlContent);
+    if (!checksums.crc32.empty()) {
+        std::cout << "Published CRC " << checksums.crc32 << std::endl;
+    }
+
     auto it = systemToRomFolder.find(console);
     if (it == systemToRomFolder.end()) {
         std::cerr << "Unsupported console: " << console << std::endl;
@@ -287,120 +494,96 @@ int downloadGame(std::string console, const std::string &htmlContent) {
     std::string romFolder = it->second;
 
     std::string downloadUrl = "https://download2.vimm.net/?mediaId=" + mediaId;
-    std::string outputPath = "/mnt/SDCARD/Roms/" + romFolder + "/" + mediaId + ".zip";
+    std::string romPath = "/mnt/SDCARD/Roms/" + romFolder;
+    std::string outputPath = romPath + "/" + mediaId + ".zip";
+    bool extract = extractFolders.count(romFolder) > 0;
 
-    void* handle = dlopen("/usr/lib/libcurl.so.4", RTLD_LAZY);
-    if (!handle) {
-        std::cerr << "Failed to load libcurl: " << dlerror() << std::endl;
+    HttpClient& http = HttpClient::instance();
+    if (!http.available()) {
         return -1;
     }
 
-    auto curl_easy_init = (curl_easy_init_t)dlsym(handle, "curl_easy_init");
-    auto curl_easy_cleanup = (curl_easy_cleanup_t)dlsym(handle, "curl_easy_cleanup");
-    auto curl_easy_setopt = (curl_easy_setopt_t)dlsym(handle, "curl_easy_setopt");
-    auto curl_easy_perform = (curl_easy_perform_t)dlsym(handle, "curl_easy_perform");
-    auto curl_easy_strerror = (curl_easy_strerror_t)dlsym(handle, "curl_easy_strerror");
-    auto curl_slist_append = (curl_slist_append_t)dlsym(handle, "curl_slist_append");
+    // Each attempt re-probes and continues from the .part file left by the last one.
+    int res = -1;
+    std::string filename;
+    for (int attempt = 1; attempt <= DOWNLOAD_RETRIES && res != 0; attempt++) {
+        if (attempt > 1) {
+            std::cerr << "Retrying download (attempt " << attempt << " of " << DOWNLOAD_RETRIES << ")" << std::endl;
+        }
+        SegmentedDownload download(http, downloadUrl, downloadHeaders());
+        download.probe();
+        filename = download.info().filename;
+
+        // A server without ranges cannot be resumed or split anyway, so a zip
+        // to unpack is unpacked straight off the wire. Otherwise the archive
+        // is downloaded in resumable segments and unpacked afterwards.
+        if (extract && hasExtension(filename, ".zip") && !download.info().acceptRanges) {
+            bool aborted = false;
+            std::string archivePath = keepArchives ? romPath + "/" + filename : "";
+            res = streamZip(http, downloadUrl, download.info().contentLength, romPath, archivePath, checksums, onProgress, aborted);
+            if (res == 0) {
+                return 0;
+            }
+            if (aborted) {
+                break;
+            }
+            continue;
+        }
+
+        res = download.run(outputPath, downloadSegments, onProgress);
+        if (download.aborted()) {
+            break;
+        }
+        // The CRC was worked out as the segments were written.
+        if (res == 0 && !matchesPublishedCrc(download.checksum(), checksums)) {
+            unlink(outputPath.c_str());
+            res = -1;
+        }
+    }
 
-    if (!curl_easy_init || !curl_easy_cleanup || !curl_easy_setopt || !curl_easy_perform) {
-        std::cerr << "Failed to resolve libcurl functions." << std::endl;
-        dlclose(handle);
+    if (res != 0) {
+        std::cerr << "Failed to download game: " << mediaId << std::endl;
         return -1;
     }
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        FILE* fp = fopen(outputPath.c_str(), "wb");
-        if (!fp) {
-            std::cerr << "Failed to open file for writing: " << outputPath << std::endl;
-            curl_easy_cleanup(curl);
-            dlclose(handle);
-            return -1;
-        }
-
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, "GET /?mediaId=33028 HTTP/1.1");
-        headers = curl_slist_append(headers, "Host: download2.vimm.net");
-        headers = curl_slist_append(headers, "Sec-Ch-Ua: \"Not;A=Brand\";v=\"24\", \"Chromium\";v=\"128\"");
-        headers = curl_slist_append(headers, "Sec-Ch-Ua-Mobile: ?0");
-        headers = curl_slist_append(headers, "Sec-Ch-Ua-Platform: \"Windows\"");
-        headers = curl_slist_append(headers, "Accept-Language: en-GB,en;q=0.9");
-        headers = curl_slist_append(headers, "Upgrade-Insecure-Requests: 1");
-        headers = curl_slist_append(headers, "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/128.0.6613.120 Safari/537.36");
-        headers = curl_slist_append(headers, "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7");
-        headers = curl_slist_append(headers, "Sec-Fetch-Site: same-site");
-        headers = curl_slist_append(headers, "Sec-Fetch-Mode: navigate");
-        headers = curl_slist_append(headers, "Sec-Fetch-User: ?1");
-        headers = curl_slist_append(headers, "Sec-Fetch-Dest: document");
-        headers = curl_slist_append(headers, "Referer: https://vimm.net/vault/40297");
-        headers = curl_slist_append(headers, "Accept-Encoding: gzip, deflate, br");
-        headers = curl_slist_append(headers, "Priority: u=0, i");
-        headers = curl_slist_append(headers, "Connection: keep-alive");
-
-        curl_easy_setopt(curl, 10023, headers);
-        curl_easy_setopt(curl, 10002, downloadUrl.c_str());
-        curl_easy_setopt(curl, 64, 0L); // Disable SSL verification
-        curl_easy_setopt(curl, 81, 0L); // Disable host verification
-        curl_easy_setopt(curl, 10001, fp);
-        curl_easy_setopt(curl, 20011, NULL);
-        curl_easy_setopt(curl, 10029, &outputPath); // WRITEHHEADER
-        
-        curl_easy_setopt(curl, 20219, progressCallback);
-        curl_easy_setopt(curl, 43, 0L);
-
-
-        std::string filename;
-        curl_easy_setopt(curl, 20079, header_callback);
-        curl_easy_setopt(curl, 10029, &filename);
-
-        int res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-        fclose(fp);
-        dlclose(handle);
-
-        if (!filename.empty()) {
-            std::string newOutputPath = "/mnt/SDCARD/Roms/" + romFolder + "/" + filename;
-            if (rename(outputPath.c_str(), newOutputPath.c_str()) == 0) {
-                std::cout << "File renamed to: " << filename << std::endl;
-            } else {
-                std::cerr << "Failed to rename file: " << strerror(errno) << std::endl;
-            }
+    if (!filename.empty()) {
+        std::string newOutputPath = romPath + "/" + filename;
+        if (rename(outputPath.c_str(), newOutputPath.c_str()) == 0) {
+            std::cout << "File renamed to: " << filename << std::endl;
+            outputPath = newOutputPath;
+        } else {
+            std::cerr << "Failed to rename file: " << strerror(errno) << std::endl;
         }
+    }
 
-        if (res != 0) {
-            std::cerr << "Failed to download game: " << curl_easy_strerror(res) << std::endl;
-            return -1;
-        } else {
-            std::cout << "Game downloaded successfully to " << outputPath << std::endl;
-            // check to see if game needs to be unzipped
-        
+    std::cout << "Game downloaded successfully to " << outputPath << std::endl;
 
-        }
-        
-    } else {
-        dlclose(handle);
-        std::cerr << "Failed to initialize curl" << std::endl;
+    if (!extract || !(hasExtension(outputPath, ".7z") || hasExtension(outputPath, ".zip"))) {
+        return 0;
+    }
+    if (extractionQueue) {
+        extractionQueue->enqueue(outputPath, romPath, !keepArchives);
+        std::cout << "Queued " << outputPath << " for extraction" << std::endl;
+        return 0;
+    }
+    // Without a queue (batch mode) the archive is unpacked here.
+    if (onExtracting) {
+        onExtracting();
+    }
+    if (extract7z(outputPath, romPath) != 0) {
         return -1;
     }
-
+    if (!keepArchives) {
+        unlink(outputPath.c_str());
+    }
     return 0;
 }
 
-int unzipGames(std::string console) {
+std::string romPathFor(const std::string& console) {
     auto it = systemToRomFolder.find(console);
     if (it == systemToRomFolder.end()) {
         std::cerr << "Unsupported console: " << console << std::endl;
-        return -1;
-    }
-    std::string romFolder = it->second;
-
-    std::string romPath = "/mnt/SDCARD/Roms/" + romFolder;
-    std::string command = "/mnt/SDCARD/System/bin/7zz x " + romPath + "/*.7z -o" + romPath + " -y";
-    int res = system(command.c_str());
-    if (res != 0) {
-        std::cerr << "Failed to unzip games: " << strerror(errno) << std::endl;
-        return -1;
+        return "";
     }
-
-    return 0;
-}
\ No newline at end of file
+    return "/mnt/SDCARD/Roms/" + it->second;
+}
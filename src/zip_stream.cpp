@@ -0,0 +1,352 @@
+#include "zip_stream.h"
+#include "crc32.h"
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const unsigned long LOCAL_HEADER_SIG = 0x04034b50;
+static const unsigned long CENTRAL_HEADER_SIG = 0x02014b50;
+static const unsigned long END_OF_CENTRAL_SIG = 0x06054b50;
+static const unsigned long DESCRIPTOR_SIG = 0x08074b50;
+static const size_t LOCAL_HEADER_SIZE = 30;
+static const size_t OUT_BUFFER_SIZE = 256 * 1024;
+
+static unsigned int read16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned long read32(const unsigned char* p) {
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static unsigned long long read64(const unsigned char* p) {
+    return read32(p) | ((unsigned long long)read32(p + 4) << 32);
+}
+
+static void makeDirectories(const std::string& path) {
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+}
+
+ZipStream::ZipStream(const std::string& outputDir)
+    : outputDir(outputDir), stage(Stage::Signature), pendingNeeded(4), fd(-1), flags(0), method(0), headerCrc(0),
+      compressedSize(0), remaining(0), zip64(false), entryFinished(false), descriptorSized(false), isFile(false), crc(0), inflaterReady(false), outBuffer(OUT_BUFFER_SIZE) {
+    memset(&inflater, 0, sizeof(inflater));
+}
+
+ZipStream::~ZipStream() {
+    if (inflaterReady) {
+        inflateEnd(&inflater);
+    }
+    if (fd >= 0) {
+        close(fd);
+        unlink(partPath.c_str());
+    }
+}
+
+const std::vector<std::string>& ZipStream::files() const {
+    return written;
+}
+
+const std::string& ZipStream::error() const {
+    return errorMessage;
+}
+
+bool ZipStream::fail(const std::string& message) {
+    if (stage != Stage::Failed) {
+        errorMessage = message;
+        std::cerr << "Zip extraction failed: " << message << std::endl;
+    }
+    stage = Stage::Failed;
+    return false;
+}
+
+// Gathers exactly `count` bytes of a fixed-size record into `pending`,
+// across as many feed() calls as it takes.
+bool ZipStream::need(const char*& data, size_t& size, size_t count) {
+    size_t take = std::min(size, count - pending.size());
+    pending.insert(pending.end(), data, data + take);
+    data += take;
+    size -= take;
+    return pending.size() == count;
+}
+
+bool ZipStream::parseHeader() {
+    const unsigned char* p = pending.data();
+    flags = read16(p + 6);
+    method = read16(p + 8);
+    headerCrc = read32(p + 14);
+    compressedSize = read32(p + 18);
+    unsigned long long uncompressedSize = read32(p + 22);
+    size_t nameLength = read16(p + 26);
+    size_t extraLength = read16(p + 28);
+    if (pending.size() < LOCAL_HEADER_SIZE + nameLength + extraLength) {
+        pendingNeeded = LOCAL_HEADER_SIZE + nameLength + extraLength;
+        return false;
+    }
+
+    name.assign((const char*)p + LOCAL_HEADER_SIZE, nameLength);
+    zip64 = false;
+    const unsigned char* extra = p + LOCAL_HEADER_SIZE + nameLength;
+    for (size_t pos = 0; pos + 4 <= extraLength;) {
+        unsigned int id = read16(extra + pos);
+        unsigned int length = read16(extra + pos + 2);
+        if (id == 0x0001 && pos + 4 + length <= extraLength) {
+            zip64 = true;
+            size_t field = pos + 4;
+            if (uncompressedSize == 0xFFFFFFFF && field + 8 <= pos + 4 + length) {
+                uncompressedSize = read64(extra + field);
+                field += 8;
+            }
+            if (compressedSize == 0xFFFFFFFF && field + 8 <= pos + 4 + length) {
+                compressedSize = read64(extra + field);
+            }
+        }
+        pos += 4 + length;
+    }
+    return true;
+}
+
+bool ZipStream::openEntry() {
+    if (flags & 0x1) {
+        return fail("encrypted entry " + name);
+    }
+    if (method != 0 && method != 8) {
+        return fail("unsupported compression method " + std::to_string(method) + " in " + name);
+    }
+    if (method == 0 && (flags & 0x8)) {
+        return fail("stored entry without sizes: " + name);
+    }
+    if (name.empty() || name[0] == '/' || name.find("..") != std::string::npos) {
+        return fail("unsafe entry name " + name);
+    }
+
+    remaining = compressedSize;
+    entryFinished = method == 0 && remaining == 0;
+    crc = 0;
+    partPath.clear();
+    isFile = name.back() != '/';
+
+    // Directory entries have no file but may still carry an empty deflate stream.
+    if (isFile && !outputDir.empty()) {
+        std::string path = outputDir + "/" + name;
+        makeDirectories(path);
+        partPath = path + ".part";
+        fd = open(partPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return fail("cannot create " + partPath + ": " + strerror(errno));
+        }
+        std::cout << "Extracting " << name << std::endl;
+    }
+    if (method == 8) {
+        if (inflaterReady) {
+            inflateReset(&inflater);
+        } else if (inflateInit2(&inflater, -MAX_WBITS) == Z_OK) {
+            inflaterReady = true;
+        } else {
+            return fail("inflateInit2 failed");
+        }
+    }
+    return true;
+}
+
+bool ZipStream::writeOut(const unsigned char* data, size_t size) {
+    crc = crc32Update(crc, data, size);
+    while (fd >= 0 && size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return fail("write to " + partPath + " failed: " + strerror(errno));
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool ZipStream::closeEntry(unsigned long expectedCrc) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    if (crc != expectedCrc) {
+        if (!partPath.empty()) {
+            unlink(partPath.c_str());
+        }
+        return fail("CRC mismatch in " + name);
+    }
+    if (partPath.empty()) {
+        return true;
+    }
+    std::string path = partPath.substr(0, partPath.size() - 5);
+    if (rename(partPath.c_str(), path.c_str()) != 0) {
+        return fail("cannot rename " + partPath + ": " + strerror(errno));
+    }
+    written.push_back(path);
+    return true;
+}
+
+size_t ZipStream::consumeStored(const char* data, size_t size) {
+    size_t take = (size_t)std::min<unsigned long long>(size, remaining);
+    if (!writeOut((const unsigned char*)data, take)) {
+        return 0;
+    }
+    remaining -= take;
+    entryFinished = remaining == 0;
+    return take;
+}
+
+size_t ZipStream::consumeDeflated(const char* data, size_t size) {
+    inflater.next_in = (Bytef*)data;
+    inflater.avail_in = size;
+    int res = Z_OK;
+    while (inflater.avail_in > 0 && res != Z_STREAM_END) {
+        inflater.next_out = outBuffer.data();
+        inflater.avail_out = outBuffer.size();
+        res = inflate(&inflater, Z_NO_FLUSH);
+        if (res != Z_OK && res != Z_STREAM_END && res != Z_BUF_ERROR) {
+            fail("corrupt deflate data in " + name);
+            return 0;
+        }
+        size_t produced = outBuffer.size() - inflater.avail_out;
+        if (produced > 0 && !writeOut(outBuffer.data(), produced)) {
+            return 0;
+        }
+        if (res == Z_BUF_ERROR && produced == 0) {
+            break;
+        }
+    }
+    // Drain output still buffered inside zlib once the input is exhausted.
+    while (res == Z_OK && inflater.avail_out == 0) {
+        inflater.next_out = outBuffer.data();
+        inflater.avail_out = outBuffer.size();
+        res = inflate(&inflater, Z_NO_FLUSH);
+        size_t produced = outBuffer.size() - inflater.avail_out;
+        if (produced > 0 && !writeOut(outBuffer.data(), produced)) {
+            return 0;
+        }
+    }
+    if (res == Z_STREAM_END) {
+        entryFinished = true;
+    }
+    return size - inflater.avail_in;
+}
+
+bool ZipStream::feed(const char* data, size_t size) {
+    while (size > 0) {
+        switch (stage) {
+            case Stage::Signature: {
+                if (!need(data, size, 4)) {
+                    return true;
+                }
+                unsigned long signature = read32(pending.data());
+                if (signature == CENTRAL_HEADER_SIG || signature == END_OF_CENTRAL_SIG) {
+                    stage = Stage::Done;
+                    pending.clear();
+                } else if (signature == LOCAL_HEADER_SIG) {
+                    stage = Stage::Header;
+                    pendingNeeded = LOCAL_HEADER_SIZE;
+                } else {
+                    return fail("not a zip stream");
+                }
+                break;
+            }
+            case Stage::Header: {
+                if (!need(data, size, pendingNeeded)) {
+                    return true;
+                }
+                if (!parseHeader()) {
+                    break; // name and extra field still to come
+                }
+                pending.clear();
+                if (!openEntry()) {
+                    return false;
+                }
+                stage = Stage::Data;
+                break;
+            }
+            case Stage::Data: {
+                size_t used = 0;
+                if (!entryFinished) {
+                    used = method == 8 ? consumeDeflated(data, size) : consumeStored(data, size);
+                    if (stage == Stage::Failed) {
+                        return false;
+                    }
+                    if (used == 0 && !entryFinished) {
+                        return fail("no progress decoding " + name);
+                    }
+                }
+                data += used;
+                size -= used;
+                if (entryFinished) {
+                    if (flags & 0x8) {
+                        stage = Stage::Descriptor;
+                        descriptorSized = false;
+                        pendingNeeded = 4;
+                    } else {
+                        if (!closeEntry(headerCrc)) {
+                            return false;
+                        }
+                        stage = Stage::Signature;
+                    }
+                }
+                break;
+            }
+            case Stage::Descriptor: {
+                // The descriptor signature is optional, so peek before sizing it.
+                if (!need(data, size, pendingNeeded)) {
+                    return true;
+                }
+                if (!descriptorSized) {
+                    if (read32(pending.data()) == DESCRIPTOR_SIG) {
+                        pending.clear();
+                    }
+                    descriptorSized = true;
+                    pendingNeeded = 4 + (zip64 ? 16 : 8);
+                    break;
+                }
+                unsigned long expected = read32(pending.data());
+                pending.clear();
+                if (!closeEntry(expected)) {
+                    return false;
+                }
+                stage = Stage::Signature;
+                break;
+            }
+            case Stage::Done:
+                return true;
+            case Stage::Failed:
+                return false;
+        }
+    }
+    return stage != Stage::Failed;
+}
+
+bool ZipStream::finish() {
+    if (stage == Stage::Done) {
+        return true;
+    }
+    if (stage != Stage::Failed) {
+        fail("archive ended before the central directory");
+    }
+    return false;
+}
+
+void ZipStream::discard() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+        unlink(partPath.c_str());
+    }
+    for (const auto& path : written) {
+        unlink(path.c_str());
+    }
+    written.clear();
+}